@@ -0,0 +1,221 @@
+#ifndef MAPBOX_UTIL_ARENA_HPP
+#define MAPBOX_UTIL_ARENA_HPP
+
+#include <cstddef> // size_t
+#include <cstdint> // uintptr_t
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "recursive_wrapper.hpp"
+#include "variant.hpp"
+
+// Arena allocated recursive trees.
+//
+// monotonic_arena hands out memory by bumping a pointer through large
+// blocks and frees all blocks at once, in release() or its destructor.
+// arena_scope makes an arena the current one for the calling thread, and
+// arena_allocator<T> allocates from the current arena (deallocate does
+// nothing). arena_recursive_wrapper<T> uses it for the nodes of a
+// recursive variant:
+//
+//     monotonic_arena arena;
+//     {
+//         arena_scope scope(arena);
+//         expression e = parse(...); // all nodes in arena
+//         ...
+//     }
+//
+// Nodes whose destruction may be skipped are not destroyed at all, see
+// is_arena_disposable. Tearing down a tree of such nodes costs nothing per
+// node, the memory comes back when the arena is released.
+
+namespace mapbox { namespace util {
+
+class monotonic_arena
+{
+    struct block
+    {
+        block* next;
+    };
+
+    // allocations are aligned one by one, the header needs no padding
+    static constexpr std::size_t header_size = sizeof(block);
+
+    block* blocks_;
+    char* current_;
+    char* end_;
+    std::size_t const block_size_;
+
+    char* add_block(std::size_t size)
+    {
+        block* b = static_cast<block*>(::operator new(header_size + size));
+        b->next = blocks_;
+        blocks_ = b;
+        return reinterpret_cast<char*>(b) + header_size;
+    }
+
+public:
+    static constexpr std::size_t default_block_size = 64 * 1024;
+
+    explicit monotonic_arena(std::size_t block_size = default_block_size)
+        : blocks_(nullptr),
+          current_(nullptr),
+          end_(nullptr),
+          block_size_(block_size) {}
+
+    monotonic_arena(monotonic_arena const&) = delete;
+    monotonic_arena& operator=(monotonic_arena const&) = delete;
+
+    ~monotonic_arena() noexcept
+    {
+        release();
+    }
+
+    void* allocate(std::size_t size, std::size_t alignment)
+    {
+        std::uintptr_t const address = reinterpret_cast<std::uintptr_t>(current_);
+        std::size_t const padding = (alignment - address % alignment) % alignment;
+        if (current_ != nullptr && padding + size <= static_cast<std::size_t>(end_ - current_))
+        {
+            char* result = current_ + padding;
+            current_ = result + size;
+            return result;
+        }
+        if (size + alignment > block_size_ / 4)
+        {
+            // large allocations get a block of their own, the current one
+            // stays in use
+            char* start = add_block(size + alignment);
+            std::size_t const offset = (alignment - reinterpret_cast<std::uintptr_t>(start) % alignment) % alignment;
+            return start + offset;
+        }
+        current_ = add_block(block_size_);
+        end_ = current_ + block_size_;
+        return allocate(size, alignment);
+    }
+
+    // frees all memory at once, nothing allocated from the arena may be
+    // used afterwards
+    void release() noexcept
+    {
+        while (blocks_ != nullptr)
+        {
+            block* next = blocks_->next;
+            ::operator delete(blocks_);
+            blocks_ = next;
+        }
+        current_ = nullptr;
+        end_ = nullptr;
+    }
+};
+
+// Makes an arena the current arena of the calling thread until the scope
+// ends. Scopes nest.
+class arena_scope
+{
+    monotonic_arena* previous_;
+
+    static monotonic_arena*& current() noexcept
+    {
+        static thread_local monotonic_arena* arena = nullptr;
+        return arena;
+    }
+
+public:
+    explicit arena_scope(monotonic_arena & arena) noexcept
+        : previous_(current())
+    {
+        current() = &arena;
+    }
+
+    arena_scope(arena_scope const&) = delete;
+    arena_scope& operator=(arena_scope const&) = delete;
+
+    ~arena_scope() noexcept
+    {
+        current() = previous_;
+    }
+
+    // the current arena of the calling thread, or nullptr
+    static monotonic_arena* active() noexcept
+    {
+        return current();
+    }
+};
+
+// Marks T as disposable: an arena allocated T is never destroyed, its
+// memory is simply reclaimed with the arena. True for trivially
+// destructible types; specialize it for node types whose members only own
+// arena memory, e.g. the children of a tree built from
+// arena_recursive_wrapper.
+template <typename T>
+struct is_arena_disposable : detail::is_trivially_destructible<T> {};
+
+template <typename T>
+class arena_allocator
+{
+public:
+    using value_type = T;
+
+    arena_allocator() noexcept {}
+
+    template <typename U>
+    arena_allocator(arena_allocator<U> const&) noexcept {}
+
+    T* allocate(std::size_t n)
+    {
+        monotonic_arena* arena = arena_scope::active();
+        if (arena == nullptr)
+        {
+            throw std::logic_error("arena_allocator used outside of an arena_scope");
+        }
+        return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, std::size_t) noexcept {}
+
+    template <typename U, typename... Args>
+    void construct(U* p, Args &&... args)
+    {
+        new (p) U(std::forward<Args>(args)...);
+    }
+
+    template <typename U>
+    void destroy(U* p) noexcept
+    {
+        destroy(p, is_arena_disposable<U>());
+    }
+
+private:
+    template <typename U>
+    void destroy(U*, std::true_type) noexcept {}
+
+    template <typename U>
+    void destroy(U* p, std::false_type) noexcept
+    {
+        p->~U();
+    }
+};
+
+template <typename T, typename U>
+inline bool operator==(arena_allocator<T> const&, arena_allocator<U> const&) noexcept
+{
+    return true;
+}
+
+template <typename T, typename U>
+inline bool operator!=(arena_allocator<T> const&, arena_allocator<U> const&) noexcept
+{
+    return false;
+}
+
+// recursive_wrapper with its node in the current arena, visitors and
+// get<T>() see T as with the plain recursive_wrapper
+template <typename T>
+using arena_recursive_wrapper = recursive_wrapper<T, arena_allocator<T>>;
+
+}}
+
+#endif // MAPBOX_UTIL_ARENA_HPP
@@ -0,0 +1,273 @@
+#ifndef MAPBOX_UTIL_FLAT_TREE_HPP
+#define MAPBOX_UTIL_FLAT_TREE_HPP
+
+#include <cstddef> // size_t
+#include <cstdint> // uint32_t
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "variant.hpp"
+
+// flat_tree<Node> - all nodes of a tree in one vector.
+//
+// Node is a variant of leaves and node types that refer to their children
+// by flat_index, a 32 bit position in the tree, instead of holding them in
+// a recursive_wrapper:
+//
+//     struct add { flat_index left; flat_index right; };
+//     using node = variant<int, add>;
+//
+//     flat_tree<node> tree;
+//     flat_index one = tree.add(1);
+//     flat_index sum = tree.add(add{one, tree.add(2)});
+//
+// Children are added before their parents, so the last node added is the
+// root. If Node is trivially copyable the tree can be written out as bytes
+// from data() and read back with assign().
+//
+// assign() checks the nodes it is given, so a corrupt buffer throws instead
+// of being visited out of bounds: every node must hold a valid alternative,
+// and its children must come before it. Node types list their children by
+// specializing flat_children, types without a specialization are leaves:
+//
+//     template <>
+//     struct flat_children<add>
+//     {
+//         template <typename F>
+//         static void for_each(add const& node, F && f)
+//         {
+//             f(node.left);
+//             f(node.right);
+//         }
+//     };
+//
+// visit(f) resolves child indices for the visitor: f is called with a node
+// and a callable that visits a child by index.
+//
+//     struct calculator
+//     {
+//         using result_type = int;
+//         template <typename Visit>
+//         int operator()(int value, Visit &) const { return value; }
+//         template <typename Visit>
+//         int operator()(add const& a, Visit & visit) const
+//         {
+//             return visit(a.left) + visit(a.right);
+//         }
+//     };
+//
+//     int result = tree.visit(calculator());
+
+namespace mapbox { namespace util {
+
+struct flat_index
+{
+    std::uint32_t value;
+};
+
+inline bool operator==(flat_index lhs, flat_index rhs)
+{
+    return lhs.value == rhs.value;
+}
+
+inline bool operator!=(flat_index lhs, flat_index rhs)
+{
+    return lhs.value != rhs.value;
+}
+
+template <typename Node>
+class flat_tree;
+
+// no children by default
+template <typename T>
+struct flat_children
+{
+    template <typename F>
+    static void for_each(T const&, F &&) {}
+};
+
+namespace detail {
+
+template <typename Node>
+struct first_alternative;
+
+template <typename First, typename... Types>
+struct first_alternative<variant<First, Types...>>
+{
+    using type = First;
+};
+
+template <typename F, typename Node, typename Visit, typename Enable = void>
+struct result_of_flat_visit
+{
+    using type = typename std::result_of<F(typename first_alternative<Node>::type const&, Visit &)>::type;
+};
+
+template <typename F, typename Node, typename Visit>
+struct result_of_flat_visit<F, Node, Visit, typename enable_if_type<typename std::remove_reference<F>::type::result_type>::type>
+{
+    using type = typename std::remove_reference<F>::type::result_type;
+};
+
+struct flat_child_check
+{
+    std::uint32_t parent;
+
+    void operator()(flat_index child) const
+    {
+        if (child.value >= parent)
+        {
+            throw std::out_of_range("flat_tree child doesn't precede its parent");
+        }
+    }
+};
+
+struct flat_node_check
+{
+    using result_type = void;
+
+    std::uint32_t index;
+
+    template <typename T>
+    void operator()(T const& node) const
+    {
+        flat_children<T>::for_each(node, flat_child_check{index});
+    }
+};
+
+} // namespace detail
+
+// the adaptor passed to the visitor of a flat_tree, call it with a child
+// index to visit the child
+template <typename Node, typename F>
+class flat_visitor
+{
+public:
+    using result_type = typename detail::result_of_flat_visit<F, Node, flat_visitor>::type;
+
+    flat_visitor(flat_tree<Node> const& tree, F & f)
+        : tree_(tree),
+          f_(f) {}
+
+    // visits a child
+    VARIANT_INLINE result_type operator()(flat_index index)
+    {
+        return apply_visitor(*this, tree_[index]);
+    }
+
+    // called by apply_visitor with the node
+    template <typename T>
+    VARIANT_INLINE result_type operator()(T const& node)
+    {
+        return f_(node, *this);
+    }
+
+private:
+    flat_tree<Node> const& tree_;
+    F & f_;
+};
+
+template <typename Node>
+class flat_tree
+{
+public:
+    using node_type = Node;
+
+    flat_tree() = default;
+
+    // a tree of the count nodes at nodes, see assign()
+    flat_tree(Node const* nodes, std::size_t count)
+    {
+        assign(nodes, count);
+    }
+
+    // replaces the nodes with copies of the count nodes at nodes, e.g. a
+    // tree written out from data(), throws std::out_of_range and leaves the
+    // tree unchanged if a node is invalid or refers to a later node
+    void assign(Node const* nodes, std::size_t count)
+    {
+        if (count > std::numeric_limits<std::uint32_t>::max())
+        {
+            throw std::length_error("flat_tree is full");
+        }
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            if (nodes[i].get_type_index() >= detail::variant_traits<Node>::size)
+            {
+                throw std::out_of_range("flat_tree node holds no valid alternative");
+            }
+            apply_visitor(detail::flat_node_check{i}, nodes[i]);
+        }
+        nodes_.assign(nodes, nodes + count);
+    }
+
+    // appends a node, its children must have been added already
+    template <typename T>
+    flat_index add(T && node)
+    {
+        if (nodes_.size() >= std::numeric_limits<std::uint32_t>::max())
+        {
+            throw std::length_error("flat_tree is full");
+        }
+        nodes_.emplace_back(std::forward<T>(node));
+        return flat_index{static_cast<std::uint32_t>(nodes_.size() - 1)};
+    }
+
+    Node const& operator[](flat_index index) const
+    {
+        return nodes_[index.value];
+    }
+
+    Node & operator[](flat_index index)
+    {
+        return nodes_[index.value];
+    }
+
+    // the last node added
+    flat_index root() const
+    {
+        if (nodes_.empty())
+        {
+            throw std::out_of_range("flat_tree is empty");
+        }
+        return flat_index{static_cast<std::uint32_t>(nodes_.size() - 1)};
+    }
+
+    std::size_t size() const { return nodes_.size(); }
+
+    bool empty() const { return nodes_.empty(); }
+
+    void reserve(std::size_t count) { nodes_.reserve(count); }
+
+    void clear() { nodes_.clear(); }
+
+    // the nodes in order, e.g. for writing them out
+    Node const* data() const { return nodes_.data(); }
+
+    // visits the node at index with f, see flat_visitor
+    template <typename F>
+    auto visit(flat_index index, F && f) const
+        -> typename flat_visitor<Node, typename std::remove_reference<F>::type>::result_type
+    {
+        flat_visitor<Node, typename std::remove_reference<F>::type> visitor(*this, f);
+        return visitor(index);
+    }
+
+    // visits the root node with f
+    template <typename F>
+    auto visit(F && f) const
+        -> typename flat_visitor<Node, typename std::remove_reference<F>::type>::result_type
+    {
+        return visit(root(), std::forward<F>(f));
+    }
+
+private:
+    std::vector<Node> nodes_;
+};
+
+}}
+
+#endif // MAPBOX_UTIL_FLAT_TREE_HPP
@@ -0,0 +1,282 @@
+#ifndef MAPBOX_UTIL_HASH_CONS_HPP
+#define MAPBOX_UTIL_HASH_CONS_HPP
+
+#include <cstddef> // size_t
+#include <functional>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "recursive_traits.hpp"
+#include "ref_count.hpp"
+#include "shared_recursive_wrapper.hpp"
+#include "variant.hpp"
+
+// hash_cons<T> - interns the nodes of recursive variant trees, so equal
+// subtrees share one node.
+//
+// Trees are built bottom up through make(), which returns the
+// shared_recursive_wrapper of an existing equal node if there is one.
+// Because the children of a node are interned before the node itself,
+// equal children are the same node: Hash and Equal only need to look at
+// the identity of boxed children, see identity_hash and identity_equal,
+// which makes interning O(1) per node and two interned trees equal iff
+// their roots are the same node. Interned nodes are always shared, so
+// mutable access clones them and never changes an interned node.
+//
+//     struct op_hash
+//     {
+//         std::size_t operator()(binary_op const& op) const
+//         {
+//             std::size_t seed = identity_hash(op.left);
+//             hash_combine(seed, identity_hash(op.right));
+//             return seed;
+//         }
+//     };
+//
+// collect() drops the nodes only the table still holds. It finds the
+// children of a dropped node through recursive_children<T> (see
+// recursive_traits.hpp) and checks them right away; without it, children
+// freed that way are only dropped by a later collect().
+//
+// hash_cons isn't thread safe, the nodes it hands out may be shared between
+// threads (with the default atomic_ref_count).
+
+namespace mapbox { namespace util {
+
+inline void hash_combine(std::size_t & seed, std::size_t value)
+{
+    seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+namespace detail {
+
+class identity_hasher
+{
+public:
+    explicit identity_hasher(std::size_t & result)
+        : result_(result) {}
+
+    template <typename W>
+    void operator()(W const& alternative) const
+    {
+        result_ = hash(alternative, is_boxed<W>());
+    }
+
+private:
+    template <typename W>
+    static std::size_t hash(W const& alternative, std::true_type)
+    {
+        return std::hash<void const*>()(owned_node<W>::get(alternative));
+    }
+
+    template <typename W>
+    static std::size_t hash(W const& alternative, std::false_type)
+    {
+        return std::hash<W>()(alternative);
+    }
+
+    std::size_t & result_;
+};
+
+template <typename V>
+class identity_comparer
+{
+public:
+    identity_comparer(V const& rhs, bool & result)
+        : rhs_(rhs),
+          result_(result) {}
+
+    template <typename W>
+    void operator()(W const& lhs) const
+    {
+        result_ = equal(lhs, rhs_.template get<W>(), is_boxed<W>());
+    }
+
+private:
+    template <typename W>
+    static bool equal(W const& lhs, W const& rhs, std::true_type)
+    {
+        return owned_node<W>::get(lhs) == owned_node<W>::get(rhs);
+    }
+
+    template <typename W>
+    static bool equal(W const& lhs, W const& rhs, std::false_type)
+    {
+        return lhs == rhs;
+    }
+
+    V const& rhs_;
+    bool & result_;
+};
+
+// collects the children of a node that hold a T, as wrappers sharing it
+template <typename T, typename RefCount>
+class interned_children
+{
+    using wrapper_type = shared_recursive_wrapper<T, RefCount>;
+
+    class alternative_visitor
+    {
+    public:
+        explicit alternative_visitor(std::vector<wrapper_type> & nodes)
+            : nodes_(nodes) {}
+
+        template <typename W>
+        void operator()(W const&) const {}
+
+        void operator()(wrapper_type const& wrapper) const
+        {
+            nodes_.push_back(wrapper);
+        }
+
+    private:
+        std::vector<wrapper_type> & nodes_;
+    };
+
+public:
+    explicit interned_children(std::vector<wrapper_type> & nodes)
+        : nodes_(nodes) {}
+
+    template <typename V>
+    void operator()(V const& child) const
+    {
+        alternative_visitor visitor(nodes_);
+        apply_to_alternative<V const, alternative_visitor>::apply(child, visitor);
+    }
+
+private:
+    std::vector<wrapper_type> & nodes_;
+};
+
+} // namespace detail
+
+// hash of a variant that uses the node address for boxed alternatives
+template <typename... Types>
+std::size_t identity_hash(variant<Types...> const& v)
+{
+    std::size_t result = 0;
+    detail::identity_hasher hasher(result);
+    detail::apply_to_alternative<variant<Types...> const, detail::identity_hasher>::apply(v, hasher);
+    hash_combine(result, static_cast<std::size_t>(v.which()));
+    return result;
+}
+
+// equality that compares boxed alternatives by node address
+template <typename... Types>
+bool identity_equal(variant<Types...> const& lhs, variant<Types...> const& rhs)
+{
+    if (lhs.which() != rhs.which()) return false;
+    bool result = false;
+    detail::identity_comparer<variant<Types...>> comparer(rhs, result);
+    detail::apply_to_alternative<variant<Types...> const, detail::identity_comparer<variant<Types...>>>::apply(lhs, comparer);
+    return result;
+}
+
+template <typename T,
+          typename Hash = std::hash<T>,
+          typename Equal = std::equal_to<T>,
+          typename RefCount = atomic_ref_count>
+class hash_cons
+{
+public:
+    using wrapper_type = shared_recursive_wrapper<T, RefCount>;
+
+    explicit hash_cons(Hash const& hash = Hash(), Equal const& equal = Equal())
+        : hash_(hash),
+          equal_(equal) {}
+
+    // the interned node equal to value
+    wrapper_type make(T const& value)
+    {
+        return intern(value);
+    }
+
+    wrapper_type make(T && value)
+    {
+        return intern(std::move(value));
+    }
+
+    // number of interned nodes
+    std::size_t size() const
+    {
+        return nodes_.size();
+    }
+
+    // drops the nodes no longer used outside the table, returns how many
+    std::size_t collect()
+    {
+        std::size_t dropped = 0;
+        // children of dropped nodes, held here so none is freed while
+        // queued: it is unused once the table and this list hold it
+        std::vector<wrapper_type> children;
+        for (auto it = nodes_.begin(); it != nodes_.end();)
+        {
+            if (it->second.unique())
+            {
+                it = drop(it, children);
+                ++dropped;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        // dropping a node can leave its children unused, one at a time
+        while (!children.empty())
+        {
+            wrapper_type const child(std::move(children.back()));
+            children.pop_back();
+            if (child.use_count() != 2) continue;
+            T const* node = child.get_pointer();
+            auto range = nodes_.equal_range(hash_(*node));
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if (static_cast<wrapper_type const&>(it->second).get_pointer() == node)
+                {
+                    drop(it, children);
+                    ++dropped;
+                    break;
+                }
+            }
+        }
+        return dropped;
+    }
+
+private:
+    using table_type = std::unordered_multimap<std::size_t, wrapper_type>;
+
+    // erases the entry at it, the interned children of its node are added
+    // to children
+    typename table_type::iterator drop(typename table_type::iterator it, std::vector<wrapper_type> & children)
+    {
+        T const& node = static_cast<wrapper_type const&>(it->second).get();
+        recursive_children<T>::for_each(node, detail::interned_children<T, RefCount>(children));
+        return nodes_.erase(it);
+    }
+
+    template <typename U>
+    wrapper_type intern(U && value)
+    {
+        std::size_t const hash = hash_(value);
+        auto range = nodes_.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            wrapper_type const& node = it->second;
+            if (equal_(node.get(), value))
+            {
+                return node;
+            }
+        }
+        return nodes_.emplace(hash, wrapper_type(std::forward<U>(value)))->second;
+    }
+
+    table_type nodes_;
+    Hash hash_;
+    Equal equal_;
+};
+
+}}
+
+#endif // MAPBOX_UTIL_HASH_CONS_HPP
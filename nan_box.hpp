@@ -0,0 +1,336 @@
+#ifndef MAPBOX_UTIL_NAN_BOX_HPP
+#define MAPBOX_UTIL_NAN_BOX_HPP
+
+#include <cstdint> // uint64_t
+#include <cstring> // memcpy
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "variant.hpp"
+
+// nan_box - a dynamic value of null, bool, int32_t, double or std::string
+// packed into 8 bytes.
+//
+// Doubles are stored as they are. Everything else lives in the payload of
+// a negative quiet NaN: the upper 16 bits hold the tag, the lower 48 bits
+// the value (bool, int32_t, or the address of a heap allocated
+// std::string). Incoming NaNs are canonicalized to a positive quiet NaN so
+// they never collide with a tag. String addresses must fit into 48 bits,
+// true for user space on x86-64 and AArch64; a string allocated above that
+// makes the constructor throw std::runtime_error.
+//
+// The string is the only alternative boxed by pointer. There is no object
+// alternative: feature properties are flat, and nested objects would need
+// a recursive value type with its own ownership and visitation. Tag 0xfffc
+// is left free for one.
+//
+// The interface follows variant<null_type, bool, std::int32_t, double,
+// std::string>: is<T>(), get<T>(), which() and apply_visitor. Scalars are
+// handed out by value since they aren't stored as such; the string by
+// reference. Moving from a nan_box leaves it null.
+
+namespace mapbox { namespace util {
+
+class nan_box;
+
+namespace detail {
+
+template <typename T>
+struct nan_box_alternative;
+
+} // namespace detail
+
+class nan_box
+{
+public:
+
+    struct null_type
+    {
+        bool operator==(null_type) const { return true; }
+    };
+
+private:
+
+    // tag - 0xfff9 is which() for boxed values, double (which() == 3) is
+    // not boxed and 0xfffc unused
+    static constexpr std::uint64_t null_tag   = 0xfff9000000000000ULL;
+    static constexpr std::uint64_t bool_tag   = 0xfffa000000000000ULL;
+    static constexpr std::uint64_t int_tag    = 0xfffb000000000000ULL;
+    static constexpr std::uint64_t string_tag = 0xfffd000000000000ULL;
+    static constexpr std::uint64_t tag_mask   = 0xffff000000000000ULL;
+    static constexpr std::uint64_t quiet_nan  = 0x7ff8000000000000ULL;
+
+    std::uint64_t bits_;
+
+    VARIANT_INLINE bool is_double() const
+    {
+        return bits_ < null_tag;
+    }
+
+    template <typename T>
+    friend struct detail::nan_box_alternative;
+
+    VARIANT_INLINE bool decode_bool() const
+    {
+        return (bits_ & 1) != 0;
+    }
+
+    VARIANT_INLINE std::int32_t decode_int() const
+    {
+        return static_cast<std::int32_t>(static_cast<std::uint32_t>(bits_));
+    }
+
+    VARIANT_INLINE double decode_double() const
+    {
+        double value;
+        std::memcpy(&value, &bits_, sizeof(value));
+        return value;
+    }
+
+    VARIANT_INLINE std::string * string_ptr() const
+    {
+        return reinterpret_cast<std::string*>(static_cast<std::uintptr_t>(bits_ & ~tag_mask));
+    }
+
+    // takes ownership of str
+    VARIANT_INLINE static std::uint64_t box_string(std::string * str)
+    {
+        std::uint64_t address = reinterpret_cast<std::uintptr_t>(str);
+        if ((address & tag_mask) != 0)
+        {
+            delete str;
+            throw std::runtime_error("nan_box: string address doesn't fit into 48 bits");
+        }
+        return address | string_tag;
+    }
+
+    VARIANT_INLINE static std::uint64_t box_double(double value)
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return (value != value) ? quiet_nan : bits; // canonicalize NaNs
+    }
+
+    VARIANT_INLINE void destroy()
+    {
+        if ((bits_ & tag_mask) == string_tag)
+        {
+            delete string_ptr();
+        }
+    }
+
+public:
+
+    VARIANT_INLINE nan_box() noexcept
+        : bits_(null_tag) {}
+
+    VARIANT_INLINE nan_box(null_type) noexcept
+        : bits_(null_tag) {}
+
+    VARIANT_INLINE nan_box(bool value) noexcept
+        : bits_(bool_tag | static_cast<std::uint64_t>(value)) {}
+
+    VARIANT_INLINE nan_box(std::int32_t value) noexcept
+        : bits_(int_tag | static_cast<std::uint32_t>(value)) {}
+
+    VARIANT_INLINE nan_box(double value) noexcept
+        : bits_(box_double(value)) {}
+
+    VARIANT_INLINE nan_box(std::string const& value)
+        : bits_(box_string(new std::string(value))) {}
+
+    VARIANT_INLINE nan_box(std::string && value)
+        : bits_(box_string(new std::string(std::move(value)))) {}
+
+    VARIANT_INLINE nan_box(char const* value)
+        : bits_(box_string(new std::string(value))) {}
+
+    VARIANT_INLINE nan_box(nan_box const& old)
+        : bits_((old.bits_ & tag_mask) == string_tag ? box_string(new std::string(*old.string_ptr())) : old.bits_) {}
+
+    VARIANT_INLINE nan_box(nan_box && old) noexcept
+        : bits_(old.bits_)
+    {
+        old.bits_ = null_tag;
+    }
+
+    VARIANT_INLINE nan_box& operator=(nan_box const& rhs)
+    {
+        // reuse the string buffer when both sides hold a string
+        if ((bits_ & tag_mask) == string_tag && (rhs.bits_ & tag_mask) == string_tag)
+        {
+            *string_ptr() = *rhs.string_ptr();
+            return *this;
+        }
+        nan_box temp(rhs);
+        return *this = std::move(temp);
+    }
+
+    VARIANT_INLINE nan_box& operator=(nan_box && rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            destroy();
+            bits_ = rhs.bits_;
+            rhs.bits_ = null_tag;
+        }
+        return *this;
+    }
+
+    ~nan_box() noexcept
+    {
+        destroy();
+    }
+
+    template <typename T>
+    VARIANT_INLINE bool is() const
+    {
+        return which() == detail::nan_box_alternative<T>::which;
+    }
+
+    VARIANT_INLINE bool valid() const { return true; }
+
+    VARIANT_INLINE int which() const noexcept
+    {
+        return is_double() ? 3 : static_cast<int>((bits_ - null_tag) >> 48);
+    }
+
+    VARIANT_INLINE std::size_t get_type_index() const
+    {
+        return static_cast<std::size_t>(4 - which());
+    }
+
+    // get<T>()
+    template <typename T>
+    VARIANT_INLINE typename detail::nan_box_alternative<T>::reference get()
+    {
+        if (is<T>())
+        {
+            return detail::nan_box_alternative<T>::get(*this);
+        }
+        else
+        {
+            throw bad_variant_access("in get<T>()");
+        }
+    }
+
+    template <typename T>
+    VARIANT_INLINE typename detail::nan_box_alternative<T>::const_reference get() const
+    {
+        if (is<T>())
+        {
+            return detail::nan_box_alternative<T>::get(*this);
+        }
+        else
+        {
+            throw bad_variant_access("in get<T>()");
+        }
+    }
+
+    // visitor
+    // const
+    template <typename F, typename V>
+    auto VARIANT_INLINE
+    static visit(V const& v, F && f)
+        -> typename detail::result_of_unary_visit<F, null_type>::type
+    {
+        if (v.is_double())
+        {
+            return std::forward<F>(f)(v.decode_double());
+        }
+        switch (v.bits_ & tag_mask)
+        {
+        case null_tag:
+            return std::forward<F>(f)(null_type());
+        case bool_tag:
+            return std::forward<F>(f)(v.decode_bool());
+        case int_tag:
+            return std::forward<F>(f)(v.decode_int());
+        default:
+            return std::forward<F>(f)(static_cast<std::string const&>(*v.string_ptr()));
+        }
+    }
+    // non-const
+    template <typename F, typename V>
+    auto VARIANT_INLINE
+    static visit(V & v, F && f)
+        -> typename detail::result_of_unary_visit<F, null_type>::type
+    {
+        if (v.is_double())
+        {
+            return std::forward<F>(f)(v.decode_double());
+        }
+        switch (v.bits_ & tag_mask)
+        {
+        case null_tag:
+            return std::forward<F>(f)(null_type());
+        case bool_tag:
+            return std::forward<F>(f)(v.decode_bool());
+        case int_tag:
+            return std::forward<F>(f)(v.decode_int());
+        default:
+            return std::forward<F>(f)(*v.string_ptr());
+        }
+    }
+};
+
+namespace detail {
+
+template <>
+struct nan_box_alternative<nan_box::null_type>
+{
+    static constexpr int which = 0;
+    using reference = nan_box::null_type;
+    using const_reference = nan_box::null_type;
+    static reference get(nan_box const&) { return reference(); }
+};
+
+template <>
+struct nan_box_alternative<bool>
+{
+    static constexpr int which = 1;
+    using reference = bool;
+    using const_reference = bool;
+    static reference get(nan_box const& v) { return v.decode_bool(); }
+};
+
+template <>
+struct nan_box_alternative<std::int32_t>
+{
+    static constexpr int which = 2;
+    using reference = std::int32_t;
+    using const_reference = std::int32_t;
+    static reference get(nan_box const& v) { return v.decode_int(); }
+};
+
+template <>
+struct nan_box_alternative<double>
+{
+    static constexpr int which = 3;
+    using reference = double;
+    using const_reference = double;
+    static reference get(nan_box const& v) { return v.decode_double(); }
+};
+
+template <>
+struct nan_box_alternative<std::string>
+{
+    static constexpr int which = 4;
+    using reference = std::string&;
+    using const_reference = std::string const&;
+    static reference get(nan_box & v) { return *v.string_ptr(); }
+    static const_reference get(nan_box const& v) { return *v.string_ptr(); }
+};
+
+} // namespace detail
+
+// moving leaves the source null, the word can be copied and the source
+// forgotten
+template <>
+struct is_trivially_relocatable<nan_box> : std::true_type {};
+
+}}
+
+#endif  // MAPBOX_UTIL_NAN_BOX_HPP
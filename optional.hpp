@@ -59,9 +59,9 @@ class optional
     }
 
     template <typename... Args>
-    void emplace(Args &&... args)
+    T & emplace(Args &&... args)
     {
-        variant_ = T{std::forward<Args>(args)...};
+        return variant_.template emplace<T>(std::forward<Args>(args)...);
     }
 
     void reset() { variant_ = none_type{}; }
@@ -0,0 +1,431 @@
+#ifndef MAPBOX_UTIL_POINTER_VARIANT_HPP
+#define MAPBOX_UTIL_POINTER_VARIANT_HPP
+
+#include <climits> // CHAR_BIT
+#include <cstddef> // size_t
+#include <cstdint> // uintptr_t
+#include <memory> // unique_ptr
+#include <type_traits>
+#include <utility>
+
+#include "recursive_wrapper.hpp"
+#include "variant.hpp"
+
+// pointer_variant<Types...> - a variant that fits into a single machine word.
+//
+// The alternatives are limited to
+//
+//  - integral types narrow enough to leave room for the tag,
+//  - raw pointers T* (not owned),
+//  - std::unique_ptr<T> and recursive_wrapper<T> (owned, heap allocated).
+//
+// The type index lives in the low bits of the word, which are always zero
+// in a pointer to a sufficiently aligned T; integers are shifted up past
+// them. With N alternatives ceil(log2(N)) bits are used, so the pointees
+// must be aligned to at least 2^ceil(log2(N)) bytes. This is checked when
+// a pointer is stored, the pointee may still be incomplete where the
+// pointer_variant type is declared.
+//
+// Visitors get the alternative unwrapped: integers by value, raw pointers
+// as T*, and owned pointers as T& (T const& when visiting a const
+// pointer_variant). Moving from a pointer_variant leaves it holding the
+// value-initialized first alternative, i.e. 0 or a null pointer. That is
+// why the first alternative must be an integer or a raw pointer: an owned
+// pointer would be null there and visiting it would dereference null.
+
+namespace mapbox { namespace util {
+
+namespace detail {
+
+// ceil(log2(N))
+template <std::size_t N>
+struct tag_bits
+{
+    static constexpr std::size_t value = (N <= 1) ? 0 : 1 + tag_bits<(N + 1) / 2>::value;
+};
+
+template <>
+struct tag_bits<1>
+{
+    static constexpr std::size_t value = 0;
+};
+
+template <typename T, std::size_t Bits, typename Enable = void>
+struct pointer_alternative;
+
+template <typename T, std::size_t Bits>
+struct pointer_alternative<T, Bits, typename std::enable_if<std::is_integral<T>::value>::type>
+{
+    static_assert(sizeof(T) * CHAR_BIT + Bits <= sizeof(std::uintptr_t) * CHAR_BIT,
+                  "integral alternative of pointer_variant leaves no room for the type index");
+
+    using reference = T;
+    using const_reference = T;
+
+    VARIANT_INLINE static std::uintptr_t encode(T value)
+    {
+        return static_cast<std::uintptr_t>(static_cast<std::intptr_t>(value)) << Bits;
+    }
+
+    // arithmetic shift restores the sign of negative values
+    VARIANT_INLINE static reference get(std::uintptr_t word)
+    {
+        return static_cast<T>(static_cast<std::intptr_t>(word) >> Bits);
+    }
+
+    VARIANT_INLINE static const_reference get_const(std::uintptr_t word)
+    {
+        return get(word);
+    }
+
+    VARIANT_INLINE static std::uintptr_t copy(std::uintptr_t word) { return word; }
+    VARIANT_INLINE static void destroy(std::uintptr_t) {}
+};
+
+template <typename T, std::size_t Bits>
+struct pointer_alternative<T*, Bits>
+{
+    using reference = T*;
+    using const_reference = T*;
+
+    VARIANT_INLINE static std::uintptr_t encode(T* ptr)
+    {
+        static_assert(alignof(T) >= (std::size_t(1) << Bits),
+                      "pointee of pointer_variant alternative is not aligned enough for the type index");
+        return reinterpret_cast<std::uintptr_t>(ptr);
+    }
+
+    VARIANT_INLINE static reference get(std::uintptr_t word)
+    {
+        return reinterpret_cast<T*>(word);
+    }
+
+    VARIANT_INLINE static const_reference get_const(std::uintptr_t word)
+    {
+        return get(word);
+    }
+
+    VARIANT_INLINE static std::uintptr_t copy(std::uintptr_t word) { return word; }
+    VARIANT_INLINE static void destroy(std::uintptr_t) {}
+};
+
+template <typename T, std::size_t Bits>
+struct owning_pointer_alternative
+{
+    using reference = T&;
+    using const_reference = T const&;
+
+    VARIANT_INLINE static std::uintptr_t encode(T* ptr)
+    {
+        static_assert(alignof(T) >= (std::size_t(1) << Bits),
+                      "pointee of pointer_variant alternative is not aligned enough for the type index");
+        return reinterpret_cast<std::uintptr_t>(ptr);
+    }
+
+    VARIANT_INLINE static reference get(std::uintptr_t word)
+    {
+        return *reinterpret_cast<T*>(word);
+    }
+
+    VARIANT_INLINE static const_reference get_const(std::uintptr_t word)
+    {
+        return *reinterpret_cast<T const*>(word);
+    }
+
+    VARIANT_INLINE static void destroy(std::uintptr_t word)
+    {
+        delete reinterpret_cast<T*>(word);
+    }
+};
+
+template <typename T, std::size_t Bits>
+struct pointer_alternative<std::unique_ptr<T>, Bits> : owning_pointer_alternative<T, Bits>
+{
+    using base = owning_pointer_alternative<T, Bits>;
+    using base::encode;
+
+    VARIANT_INLINE static std::uintptr_t encode(std::unique_ptr<T> && ptr)
+    {
+        return encode(ptr.release());
+    }
+
+    template <typename U = T>
+    VARIANT_INLINE static std::uintptr_t copy(std::uintptr_t)
+    {
+        static_assert(!std::is_same<U, T>::value, "pointer_variant with a std::unique_ptr alternative can't be copied");
+        return 0;
+    }
+};
+
+template <typename T, std::size_t Bits>
+struct pointer_alternative<recursive_wrapper<T>, Bits> : owning_pointer_alternative<T, Bits>
+{
+    using base = owning_pointer_alternative<T, Bits>;
+    using base::encode;
+
+    VARIANT_INLINE static std::uintptr_t encode(recursive_wrapper<T> const& wrapper)
+    {
+        return encode(new T(wrapper.get()));
+    }
+
+    VARIANT_INLINE static std::uintptr_t encode(recursive_wrapper<T> && wrapper)
+    {
+        return encode(new T(std::move(wrapper.get())));
+    }
+
+    VARIANT_INLINE static std::uintptr_t encode(T const& value)
+    {
+        return encode(new T(value));
+    }
+
+    VARIANT_INLINE static std::uintptr_t encode(T && value)
+    {
+        return encode(new T(std::move(value)));
+    }
+
+    template <typename U = T>
+    VARIANT_INLINE static std::uintptr_t copy(std::uintptr_t word)
+    {
+        return encode(new U(base::get_const(word)));
+    }
+};
+
+// Walks the alternatives comparing the tag, like dispatcher; the tag is
+// always valid so the last alternative needs no check.
+template <std::size_t Bits, typename... Types>
+struct pointer_variant_helper;
+
+template <std::size_t Bits, typename T, typename... Types>
+struct pointer_variant_helper<Bits, T, Types...>
+{
+    using alternative = pointer_alternative<T, Bits>;
+    using next = pointer_variant_helper<Bits, Types...>;
+
+    template <typename R, typename F>
+    VARIANT_INLINE static R visit_const(std::size_t tag, std::uintptr_t payload, F && f)
+    {
+        if (tag == sizeof...(Types))
+        {
+            return std::forward<F>(f)(alternative::get_const(payload));
+        }
+        return next::template visit_const<R>(tag, payload, std::forward<F>(f));
+    }
+
+    template <typename R, typename F>
+    VARIANT_INLINE static R visit(std::size_t tag, std::uintptr_t payload, F && f)
+    {
+        if (tag == sizeof...(Types))
+        {
+            return std::forward<F>(f)(alternative::get(payload));
+        }
+        return next::template visit<R>(tag, payload, std::forward<F>(f));
+    }
+
+    VARIANT_INLINE static std::uintptr_t copy(std::size_t tag, std::uintptr_t payload)
+    {
+        if (tag == sizeof...(Types))
+        {
+            return alternative::copy(payload);
+        }
+        return next::copy(tag, payload);
+    }
+
+    VARIANT_INLINE static void destroy(std::size_t tag, std::uintptr_t payload)
+    {
+        if (tag == sizeof...(Types))
+        {
+            alternative::destroy(payload);
+        }
+        else
+        {
+            next::destroy(tag, payload);
+        }
+    }
+};
+
+template <std::size_t Bits, typename T>
+struct pointer_variant_helper<Bits, T>
+{
+    using alternative = pointer_alternative<T, Bits>;
+
+    template <typename R, typename F>
+    VARIANT_INLINE static R visit_const(std::size_t, std::uintptr_t payload, F && f)
+    {
+        return std::forward<F>(f)(alternative::get_const(payload));
+    }
+
+    template <typename R, typename F>
+    VARIANT_INLINE static R visit(std::size_t, std::uintptr_t payload, F && f)
+    {
+        return std::forward<F>(f)(alternative::get(payload));
+    }
+
+    VARIANT_INLINE static std::uintptr_t copy(std::size_t, std::uintptr_t payload)
+    {
+        return alternative::copy(payload);
+    }
+
+    VARIANT_INLINE static void destroy(std::size_t, std::uintptr_t payload)
+    {
+        alternative::destroy(payload);
+    }
+};
+
+} // namespace detail
+
+template <typename... Types>
+class pointer_variant
+{
+    static_assert(sizeof...(Types) > 0, "Template parameter type list of pointer_variant can not be empty");
+
+private:
+
+    static constexpr std::size_t bits = detail::tag_bits<sizeof...(Types)>::value;
+    static constexpr std::uintptr_t tag_mask = (std::uintptr_t(1) << bits) - 1;
+
+    using first_type = typename std::tuple_element<0, std::tuple<Types...>>::type;
+
+    static_assert(std::is_integral<first_type>::value || std::is_pointer<first_type>::value,
+                  "First type in pointer_variant must be an integral type or a raw pointer, it is held when default constructed or moved from");
+    using helper_type = detail::pointer_variant_helper<bits, Types...>;
+
+    template <typename T>
+    using alternative = detail::pointer_alternative<T, bits>;
+
+    std::uintptr_t word;
+
+    VARIANT_INLINE std::size_t tag() const
+    {
+        return static_cast<std::size_t>(word & tag_mask);
+    }
+
+    VARIANT_INLINE std::uintptr_t payload() const
+    {
+        return word & ~tag_mask;
+    }
+
+    // the value-initialized first alternative, 0 or a null pointer
+    static constexpr std::uintptr_t empty_word = sizeof...(Types) - 1;
+
+public:
+
+    VARIANT_INLINE pointer_variant() noexcept
+        : word(empty_word) {}
+
+    template <typename T, typename Traits = detail::value_traits<typename std::decay<T>::type, Types...>,
+              typename Enable = typename std::enable_if<Traits::index != detail::invalid_value>::type>
+    VARIANT_INLINE pointer_variant(T && val)
+        : word(alternative<typename std::tuple_element<sizeof...(Types) - Traits::index - 1, std::tuple<Types...>>::type>
+               ::encode(std::forward<T>(val)) | Traits::index) {}
+
+    VARIANT_INLINE pointer_variant(pointer_variant const& old)
+        : word(helper_type::copy(old.tag(), old.payload()) | old.tag()) {}
+
+    VARIANT_INLINE pointer_variant(pointer_variant && old) noexcept
+        : word(old.word)
+    {
+        old.word = empty_word;
+    }
+
+    VARIANT_INLINE pointer_variant& operator=(pointer_variant const& rhs)
+    {
+        pointer_variant temp(rhs);
+        return *this = std::move(temp);
+    }
+
+    VARIANT_INLINE pointer_variant& operator=(pointer_variant && rhs) noexcept
+    {
+        if (this != &rhs)
+        {
+            helper_type::destroy(tag(), payload());
+            word = rhs.word;
+            rhs.word = empty_word;
+        }
+        return *this;
+    }
+
+    ~pointer_variant() noexcept
+    {
+        helper_type::destroy(tag(), payload());
+    }
+
+    template <typename T>
+    VARIANT_INLINE bool is() const
+    {
+        static_assert(detail::has_type<T, Types...>::value, "invalid type in T in `is<T>()` for this pointer_variant");
+        return tag() == detail::direct_type<T, Types...>::index;
+    }
+
+    VARIANT_INLINE bool valid() const { return true; }
+
+    VARIANT_INLINE std::size_t get_type_index() const
+    {
+        return tag();
+    }
+
+    VARIANT_INLINE int which() const noexcept
+    {
+        return static_cast<int>(sizeof...(Types) - tag() - 1);
+    }
+
+    // get<T>() - T is the alternative as listed, returns what a visitor
+    // would get for it
+    template <typename T, typename std::enable_if<
+                          (detail::direct_type<T, Types...>::index != detail::invalid_value)
+                          >::type* = nullptr>
+    VARIANT_INLINE typename alternative<T>::reference get()
+    {
+        if (tag() == detail::direct_type<T, Types...>::index)
+        {
+            return alternative<T>::get(payload());
+        }
+        else
+        {
+            throw bad_variant_access("in get<T>()");
+        }
+    }
+
+    template <typename T, typename std::enable_if<
+                          (detail::direct_type<T, Types...>::index != detail::invalid_value)
+                          >::type* = nullptr>
+    VARIANT_INLINE typename alternative<T>::const_reference get() const
+    {
+        if (tag() == detail::direct_type<T, Types...>::index)
+        {
+            return alternative<T>::get_const(payload());
+        }
+        else
+        {
+            throw bad_variant_access("in get<T>()");
+        }
+    }
+
+    // visitor
+    // const
+    template <typename F, typename V>
+    auto VARIANT_INLINE
+    static visit(V const& v, F && f)
+        -> typename detail::result_of_unary_visit<F, typename alternative<first_type>::const_reference>::type
+    {
+        using R = typename detail::result_of_unary_visit<F, typename alternative<first_type>::const_reference>::type;
+        return helper_type::template visit_const<R>(v.tag(), v.payload(), std::forward<F>(f));
+    }
+    // non-const
+    template <typename F, typename V>
+    auto VARIANT_INLINE
+    static visit(V & v, F && f)
+        -> typename detail::result_of_unary_visit<F, typename alternative<first_type>::reference>::type
+    {
+        using R = typename detail::result_of_unary_visit<F, typename alternative<first_type>::reference>::type;
+        return helper_type::template visit<R>(v.tag(), v.payload(), std::forward<F>(f));
+    }
+};
+
+// moving leaves the source holding a plain integer, so the word can be
+// copied and the source forgotten
+template <typename... Types>
+struct is_trivially_relocatable<pointer_variant<Types...>> : std::true_type {};
+
+}}
+
+#endif  // MAPBOX_UTIL_POINTER_VARIANT_HPP
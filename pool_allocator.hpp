@@ -0,0 +1,256 @@
+#ifndef MAPBOX_UTIL_POOL_ALLOCATOR_HPP
+#define MAPBOX_UTIL_POOL_ALLOCATOR_HPP
+
+#include <cstddef> // size_t
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "recursive_wrapper.hpp"
+
+// pool_allocator<T> - a stateless allocator for single nodes, meant for
+// recursive_wrapper, see pooled_recursive_wrapper below.
+//
+// Single objects of up to max_pooled_size bytes come from a pool per size
+// class (a multiple of pool_granularity). Every thread keeps its own free
+// list per size class, so allocating and freeing a node doesn't take a
+// lock. A thread only takes the lock to refill an empty list, either from
+// the blocks handed back by other threads or from a fresh chunk. A block
+// may be freed on a different thread than it was allocated on, it then
+// joins that thread's free list; once a list grows past pool_high_water
+// bytes worth of blocks, a chunk's worth is handed back for other threads
+// to reuse, so a thread that only frees doesn't hoard memory. The lists of
+// exiting threads are handed back whole; blocks allocated or freed after
+// that, e.g. by other thread_local destructors, go straight to and from the
+// shared pool. Chunks are kept until the process exits. Arrays and larger
+// objects go to operator new.
+
+namespace mapbox { namespace util {
+
+namespace detail {
+
+static constexpr std::size_t pool_granularity = 16;
+static constexpr std::size_t max_pooled_size = 256;
+static constexpr std::size_t pool_chunk_size = 64 * 1024;
+static constexpr std::size_t pool_high_water = 2 * pool_chunk_size;
+
+struct pool_block
+{
+    pool_block* next;
+    pool_block* next_batch; // set on the first block of a handed back list
+};
+
+static_assert(sizeof(pool_block) <= pool_granularity, "a free block must fit the smallest size class");
+
+// a null terminated list of free blocks
+struct pool_batch
+{
+    pool_block* head;
+    std::size_t count;
+};
+
+// process wide state of one size class
+class pool_depot
+{
+public:
+    explicit pool_depot(std::size_t block_size)
+        : block_size_(block_size),
+          batches_(nullptr) {}
+
+    // a list of free blocks, never empty
+    pool_batch refill()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (batches_ != nullptr)
+        {
+            pool_batch batch{batches_, 0};
+            batches_ = batches_->next_batch;
+            lock.unlock();
+            for (pool_block* block = batch.head; block != nullptr; block = block->next) ++batch.count;
+            return batch;
+        }
+        std::size_t const count = pool_chunk_size / block_size_;
+        char* chunk = static_cast<char*>(::operator new(count * block_size_));
+        chunks_.push_back(chunk);
+        pool_block* head = nullptr;
+        for (std::size_t i = count; i-- > 0;)
+        {
+            pool_block* block = reinterpret_cast<pool_block*>(chunk + i * block_size_);
+            block->next = head;
+            head = block;
+        }
+        return pool_batch{head, count};
+    }
+
+    // takes back a list of free blocks for other threads
+    void give_back(pool_block* head)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        head->next_batch = batches_;
+        batches_ = head;
+    }
+
+private:
+    std::size_t const block_size_;
+    std::mutex mutex_;
+    std::vector<char*> chunks_;
+    pool_block* batches_;
+};
+
+template <std::size_t BlockSize>
+class node_pool
+{
+    static constexpr std::size_t batch_size = pool_chunk_size / BlockSize;
+    static constexpr std::size_t high_water = pool_high_water / BlockSize;
+
+    struct free_list
+    {
+        pool_block* head = nullptr;
+        std::size_t count = 0;
+
+        ~free_list()
+        {
+            if (head != nullptr) depot().give_back(head);
+            // the list must not be touched once it is destroyed, blocks
+            // freed later by other thread_local destructors bypass it
+            destroyed() = true;
+        }
+    };
+
+    // never destroyed, blocks may be freed during static destruction
+    static pool_depot& depot()
+    {
+        static pool_depot* instance = new pool_depot(BlockSize);
+        return *instance;
+    }
+
+    static free_list& local()
+    {
+        static thread_local free_list list;
+        return list;
+    }
+
+    // trivially destructible, so it outlives the list until the thread exits
+    static bool& destroyed()
+    {
+        static thread_local bool flag = false;
+        return flag;
+    }
+
+public:
+    static void* allocate()
+    {
+        if (destroyed())
+        {
+            pool_batch batch = depot().refill();
+            pool_block* block = batch.head;
+            if (block->next != nullptr) depot().give_back(block->next);
+            return block;
+        }
+        free_list & list = local();
+        if (list.head == nullptr)
+        {
+            pool_batch batch = depot().refill();
+            list.head = batch.head;
+            list.count = batch.count;
+        }
+        pool_block* block = list.head;
+        list.head = block->next;
+        --list.count;
+        return block;
+    }
+
+    static void deallocate(void* p) noexcept
+    {
+        pool_block* block = static_cast<pool_block*>(p);
+        if (destroyed())
+        {
+            block->next = nullptr;
+            depot().give_back(block);
+            return;
+        }
+        free_list & list = local();
+        block->next = list.head;
+        list.head = block;
+        if (++list.count >= high_water)
+        {
+            // hand the newest batch_size blocks back
+            pool_block* head = list.head;
+            pool_block* tail = head;
+            for (std::size_t i = 1; i < batch_size; ++i) tail = tail->next;
+            list.head = tail->next;
+            list.count -= batch_size;
+            tail->next = nullptr;
+            depot().give_back(head);
+        }
+    }
+
+    // number of free blocks on the calling thread's list
+    static std::size_t local_free() noexcept
+    {
+        return destroyed() ? 0 : local().count;
+    }
+};
+
+template <typename T>
+struct pool_size_class
+{
+    static constexpr bool pooled = sizeof(T) <= max_pooled_size && alignof(T) <= pool_granularity;
+    static constexpr std::size_t block_size = (sizeof(T) + pool_granularity - 1) / pool_granularity * pool_granularity;
+};
+
+} // namespace detail
+
+template <typename T>
+class pool_allocator
+{
+public:
+    using value_type = T;
+
+    pool_allocator() noexcept {}
+
+    template <typename U>
+    pool_allocator(pool_allocator<U> const&) noexcept {}
+
+    T* allocate(std::size_t n)
+    {
+        if (n == 1 && detail::pool_size_class<T>::pooled)
+        {
+            return static_cast<T*>(detail::node_pool<detail::pool_size_class<T>::block_size>::allocate());
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        if (n == 1 && detail::pool_size_class<T>::pooled)
+        {
+            detail::node_pool<detail::pool_size_class<T>::block_size>::deallocate(p);
+        }
+        else
+        {
+            ::operator delete(p);
+        }
+    }
+};
+
+template <typename T, typename U>
+inline bool operator==(pool_allocator<T> const&, pool_allocator<U> const&) noexcept
+{
+    return true;
+}
+
+template <typename T, typename U>
+inline bool operator!=(pool_allocator<T> const&, pool_allocator<U> const&) noexcept
+{
+    return false;
+}
+
+// recursive_wrapper with its nodes allocated from the pools, visitors
+// and get<T>() see T as with the plain recursive_wrapper
+template <typename T>
+using pooled_recursive_wrapper = recursive_wrapper<T, pool_allocator<T>>;
+
+}}
+
+#endif // MAPBOX_UTIL_POOL_ALLOCATOR_HPP
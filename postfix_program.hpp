@@ -0,0 +1,205 @@
+#ifndef MAPBOX_UTIL_POSTFIX_PROGRAM_HPP
+#define MAPBOX_UTIL_POSTFIX_PROGRAM_HPP
+
+#include <cstddef> // size_t
+#include <cstdint> // uint32_t
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "recursive_traits.hpp"
+#include "variant.hpp"
+
+// postfix_program<Value, Opcode> - an expression compiled to a flat list of
+// postfix instructions, evaluated by one loop over a value stack instead of
+// a recursive visit.
+//
+// An instruction either pushes a constant or applies an opcode to the
+// topmost values, replacing them with the result. evaluate(f) calls
+// f(opcode, args, arity) for the latter, with args pointing to the arity
+// operands in order; a switch over the opcode in f is inlined into the
+// loop.
+//
+// compile_postfix() turns a recursive variant tree into a program. It
+// walks the tree in post-order (children listed by recursive_children<T>,
+// see recursive_traits.hpp) with an explicit stack, and calls
+// rules(node, program) for each node after its children, where the rules
+// push a constant or apply an opcode:
+//
+//     struct rules
+//     {
+//         void operator()(int value, program_type & p) const { p.push(value); }
+//         void operator()(binary_op<add> const&, program_type & p) const { p.apply(opcode::add, 2); }
+//     };
+
+namespace mapbox { namespace util {
+
+template <typename Value, typename Opcode>
+class postfix_program
+{
+public:
+    using value_type = Value;
+    using opcode_type = Opcode;
+
+    struct instruction
+    {
+        std::uint32_t operand; // index of the constant or arity
+        Opcode opcode;
+        bool push;
+    };
+
+    postfix_program()
+        : depth_(0),
+          max_depth_(0) {}
+
+    // appends an instruction pushing value
+    void push(Value const& value)
+    {
+        constants_.push_back(value);
+        add_push();
+    }
+
+    void push(Value && value)
+    {
+        constants_.push_back(std::move(value));
+        add_push();
+    }
+
+    // appends an instruction applying opcode to the arity topmost values
+    void apply(Opcode opcode, std::uint32_t arity)
+    {
+        if (arity > depth_)
+        {
+            throw std::logic_error("postfix_program: not enough operands");
+        }
+        instruction i;
+        i.operand = arity;
+        i.opcode = opcode;
+        i.push = false;
+        code_.push_back(i);
+        depth_ = depth_ - arity + 1;
+        if (depth_ > max_depth_) max_depth_ = depth_;
+    }
+
+    // evaluates the program, reusing stack between calls
+    template <typename F>
+    Value evaluate(F && f, std::vector<Value> & stack) const
+    {
+        if (depth_ != 1)
+        {
+            throw std::logic_error("postfix_program: program doesn't leave exactly one value");
+        }
+        if (stack.size() < max_depth_) stack.resize(max_depth_);
+        Value* top = stack.data();
+        for (instruction const& i : code_)
+        {
+            if (i.push)
+            {
+                *top++ = constants_[i.operand];
+            }
+            else
+            {
+                top -= i.operand;
+                Value result = f(i.opcode, static_cast<Value const*>(top), static_cast<std::size_t>(i.operand));
+                *top++ = std::move(result);
+            }
+        }
+        return std::move(*(top - 1));
+    }
+
+    template <typename F>
+    Value evaluate(F && f) const
+    {
+        std::vector<Value> stack;
+        return evaluate(std::forward<F>(f), stack);
+    }
+
+    std::vector<instruction> const& code() const { return code_; }
+
+    std::vector<Value> const& constants() const { return constants_; }
+
+    // largest number of values on the stack during evaluation
+    std::size_t max_depth() const { return max_depth_; }
+
+private:
+    void add_push()
+    {
+        instruction i;
+        i.operand = static_cast<std::uint32_t>(constants_.size() - 1);
+        i.opcode = Opcode();
+        i.push = true;
+        code_.push_back(i);
+        if (++depth_ > max_depth_) max_depth_ = depth_;
+    }
+
+    std::vector<instruction> code_;
+    std::vector<Value> constants_;
+    std::size_t depth_;
+    std::size_t max_depth_;
+};
+
+namespace detail {
+
+template <typename Rules, typename Program>
+class postfix_emitter
+{
+public:
+    using result_type = void;
+
+    postfix_emitter(Rules & rules, Program & program)
+        : rules_(rules),
+          program_(program) {}
+
+    template <typename T>
+    void operator()(T const& node) const
+    {
+        rules_(node, program_);
+    }
+
+private:
+    Rules & rules_;
+    Program & program_;
+};
+
+} // namespace detail
+
+// compiles tree, see above
+template <typename Value, typename Opcode, typename V, typename Rules>
+postfix_program<Value, Opcode> compile_postfix(V const& tree, Rules && rules)
+{
+    using program_type = postfix_program<Value, Opcode>;
+    using rules_type = typename std::remove_reference<Rules>::type;
+
+    program_type program;
+    detail::postfix_emitter<rules_type, program_type> emitter(rules, program);
+
+    // a node is pushed once to list its children and once more, marked
+    // done, to be emitted after them
+    std::vector<std::pair<V const*, bool>> pending{std::make_pair(&tree, false)};
+    std::vector<V const*> children;
+    while (!pending.empty())
+    {
+        std::pair<V const*, bool> current = pending.back();
+        pending.pop_back();
+        if (current.second)
+        {
+            apply_visitor(emitter, *current.first);
+            continue;
+        }
+        pending.emplace_back(current.first, true);
+        children.clear();
+        for_each_child(*current.first, [&children](V const& child) {
+            children.push_back(&child);
+        });
+        for (auto it = children.rbegin(); it != children.rend(); ++it)
+        {
+            pending.emplace_back(*it, false);
+        }
+    }
+    return program;
+}
+
+}}
+
+#endif // MAPBOX_UTIL_POSTFIX_PROGRAM_HPP
@@ -0,0 +1,330 @@
+#ifndef MAPBOX_UTIL_RECURSIVE_TRAITS_HPP
+#define MAPBOX_UTIL_RECURSIVE_TRAITS_HPP
+
+#include <cassert>
+#include <cstddef> // size_t
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "recursive_wrapper.hpp"
+#include "shared_recursive_wrapper.hpp"
+#include "variant.hpp"
+
+// Generic access to the children of recursive variant trees, and
+// destruction and deep copy with an explicit work list instead of C++
+// recursion, so deep trees don't overflow the stack.
+//
+// A tree is a variant V whose alternatives are leaves or node types, held
+// inline or through recursive_wrapper, shared_recursive_wrapper or
+// std::unique_ptr. Node types list their children (of type V) by
+// specializing recursive_children:
+//
+//     template <typename Op>
+//     struct recursive_children<binary_op<Op>>
+//     {
+//         template <typename Node, typename F>
+//         static void for_each(Node & node, F && f)
+//         {
+//             f(node.left);
+//             f(node.right);
+//         }
+//
+//         // only needed for iterative_copy()
+//         static binary_op<Op> copy_node(binary_op<Op> const&)
+//         {
+//             return binary_op<Op>(expression(), expression());
+//         }
+//     };
+//
+// Node is the node type, const or not. copy_node() copies a node with
+// default constructed children in their place, iterative_copy() fills them
+// in afterwards.
+
+namespace mapbox { namespace util {
+
+// no children by default
+template <typename T>
+struct recursive_children
+{
+    template <typename Node, typename F>
+    static void for_each(Node &, F &&) {}
+
+    static T copy_node(T const& node) { return node; }
+};
+
+namespace detail {
+
+// the node held by an alternative W, as far as it may be accessed without
+// a copy: mutable access to a shared node isn't given
+template <typename W>
+struct owned_node
+{
+    using type = W;
+    static W* get(W & w) { return &w; }
+    static W const* get(W const& w) { return &w; }
+};
+
+template <typename T, typename Alloc>
+struct owned_node<recursive_wrapper<T, Alloc>>
+{
+    using type = T;
+    static T* get(recursive_wrapper<T, Alloc> & w) { return w.get_pointer(); }
+    static T const* get(recursive_wrapper<T, Alloc> const& w) { return w.get_pointer(); }
+};
+
+template <typename T, typename RefCount>
+struct owned_node<shared_recursive_wrapper<T, RefCount>>
+{
+    using type = T;
+    static T* get(shared_recursive_wrapper<T, RefCount> & w) { return w.unique() ? w.get_pointer() : nullptr; }
+    static T const* get(shared_recursive_wrapper<T, RefCount> const& w) { return w.get_pointer(); }
+};
+
+template <typename T, typename Deleter>
+struct owned_node<std::unique_ptr<T, Deleter>>
+{
+    using type = T;
+    static T* get(std::unique_ptr<T, Deleter> & w) { return w.get(); }
+    static T const* get(std::unique_ptr<T, Deleter> const& w) { return w.get(); }
+};
+
+template <typename W>
+struct is_shared_node : std::false_type {};
+
+template <typename T, typename RefCount>
+struct is_shared_node<shared_recursive_wrapper<T, RefCount>> : std::true_type {};
+
+// whether tree V has shared nodes, whose children a non-const walk can't reach
+template <typename V>
+struct has_shared_nodes : std::false_type {};
+
+template <typename... Types>
+struct has_shared_nodes<variant<Types...>>
+    : std::integral_constant<bool, !static_all<!is_shared_node<Types>::value...>::value> {};
+
+// calls f with the active alternative itself, wrappers included
+template <typename V, typename F, typename... Types>
+struct alternative_dispatcher;
+
+template <typename V, typename F, typename T, typename... Types>
+struct alternative_dispatcher<V, F, T, Types...>
+{
+    VARIANT_INLINE static void apply(V & v, F & f)
+    {
+        if (v.template is<T>())
+        {
+            f(v.template get<T>());
+        }
+        else
+        {
+            alternative_dispatcher<V, F, Types...>::apply(v, f);
+        }
+    }
+};
+
+template <typename V, typename F, typename T>
+struct alternative_dispatcher<V, F, T>
+{
+    VARIANT_INLINE static void apply(V & v, F & f)
+    {
+        f(v.template get<T>());
+    }
+};
+
+template <typename V, typename F>
+struct apply_to_alternative;
+
+template <typename F, typename... Types>
+struct apply_to_alternative<variant<Types...>, F>
+{
+    static void apply(variant<Types...> & v, F & f)
+    {
+        alternative_dispatcher<variant<Types...>, F, Types...>::apply(v, f);
+    }
+};
+
+template <typename F, typename... Types>
+struct apply_to_alternative<variant<Types...> const, F>
+{
+    static void apply(variant<Types...> const& v, F & f)
+    {
+        alternative_dispatcher<variant<Types...> const, F, Types...>::apply(v, f);
+    }
+};
+
+template <typename F>
+class children_visitor
+{
+public:
+    explicit children_visitor(F & f)
+        : f_(f) {}
+
+    template <typename W>
+    void operator()(W & alternative) const
+    {
+        using bare_type = typename std::remove_const<W>::type;
+        using node_type = typename owned_node<bare_type>::type;
+        auto node = owned_node<bare_type>::get(alternative);
+        if (node != nullptr)
+        {
+            recursive_children<node_type>::for_each(*node, f_);
+        }
+    }
+
+private:
+    F & f_;
+};
+
+} // namespace detail
+
+namespace detail {
+
+template <typename T, typename Enable = void>
+struct has_copy_node : std::false_type {};
+
+template <typename T>
+struct has_copy_node<T, typename enable_if_type<decltype(recursive_children<T>::copy_node(std::declval<T const&>()))>::type>
+    : std::true_type {};
+
+template <typename T>
+T copy_node(T const& node)
+{
+    static_assert(has_copy_node<T>::value, "iterative_copy() needs recursive_children<T>::copy_node() for node types with children");
+    return recursive_children<T>::copy_node(node);
+}
+
+// copies the root node of a tree into target, children left default
+// constructed; shared nodes are shared, their children need no copy
+template <typename V>
+class node_copier
+{
+public:
+    node_copier(V & target, bool & has_children)
+        : target_(target),
+          has_children_(has_children) {}
+
+    template <typename W>
+    void operator()(W const& alternative) const
+    {
+        target_ = copy_node(alternative);
+        has_children_ = true;
+    }
+
+    template <typename T, typename Alloc>
+    void operator()(recursive_wrapper<T, Alloc> const& wrapper) const
+    {
+        target_ = recursive_wrapper<T, Alloc>(copy_node(wrapper.get()));
+        has_children_ = true;
+    }
+
+    template <typename T, typename RefCount>
+    void operator()(shared_recursive_wrapper<T, RefCount> const& wrapper) const
+    {
+        target_ = wrapper;
+        has_children_ = false;
+    }
+
+    template <typename T, typename Deleter>
+    void operator()(std::unique_ptr<T, Deleter> const& ptr) const
+    {
+        if (ptr)
+        {
+            target_ = std::unique_ptr<T, Deleter>(new T(copy_node(*ptr)), ptr.get_deleter());
+        }
+        else
+        {
+            target_ = std::unique_ptr<T, Deleter>(nullptr, ptr.get_deleter());
+        }
+        has_children_ = static_cast<bool>(ptr);
+    }
+
+private:
+    V & target_;
+    bool & has_children_;
+};
+
+} // namespace detail
+
+// Calls f(child) for each child of the root node of tree. When tree isn't
+// const, the children of a shared node are only handed out while no other
+// tree shares it (so iterative_destroy() leaves shared subtrees alone);
+// pass a const tree to see them all.
+template <typename V, typename F>
+VARIANT_INLINE void for_each_child(V & tree, F && f)
+{
+    detail::children_visitor<typename std::remove_reference<F>::type> visitor(f);
+    detail::apply_to_alternative<V, detail::children_visitor<typename std::remove_reference<F>::type>>::apply(tree, visitor);
+}
+
+// Destroys the nodes of tree one by one, taking the children of each node
+// out before the node goes away, so every destructor is shallow. Stack use
+// is bounded whatever the depth. tree is left moved from.
+template <typename V>
+void iterative_destroy(V & tree)
+{
+    std::vector<V> pending;
+    pending.push_back(std::move(tree));
+    while (!pending.empty())
+    {
+        V current(std::move(pending.back()));
+        pending.pop_back();
+        for_each_child(current, [&pending](V & child) {
+            pending.push_back(std::move(child));
+        });
+    }
+}
+
+// Deep copy of tree, one node at a time: each node is copied without its
+// children (see copy_node() above), whose copies are then made into the
+// empty slots. The source isn't changed, so it may be read by other threads
+// meanwhile. Shared nodes are shared by the copy. Requires V to be default
+// constructible.
+template <typename V>
+V iterative_copy(V const& tree)
+{
+    struct task
+    {
+        V const* source;
+        V* target;
+    };
+
+    V result;
+    std::vector<task> pending{task{&tree, &result}};
+    std::vector<V const*> sources;
+    try
+    {
+        while (!pending.empty())
+        {
+            task current = pending.back();
+            pending.pop_back();
+
+            bool has_children = false;
+            detail::node_copier<V> copier(*current.target, has_children);
+            detail::apply_to_alternative<V const, detail::node_copier<V>>::apply(*current.source, copier);
+            if (!has_children) continue;
+
+            sources.clear();
+            for_each_child(*current.source, [&sources](V const& child) {
+                sources.push_back(&child);
+            });
+            std::size_t i = 0;
+            for_each_child(*current.target, [&pending, &sources, &i](V & child) {
+                assert(i < sources.size());
+                pending.push_back(task{sources[i++], &child});
+            });
+            assert(i == sources.size());
+        }
+    }
+    catch (...)
+    {
+        iterative_destroy(result);
+        throw;
+    }
+    return result;
+}
+
+}}
+
+#endif // MAPBOX_UTIL_RECURSIVE_TRAITS_HPP
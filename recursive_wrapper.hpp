@@ -13,24 +13,51 @@
 // http://www.boost.org/LICENSE_1_0.txt)
 
 #include <cassert>
+#include <memory>
 #include <utility>
 
 namespace mapbox { namespace util {
 
-template <typename T>
+// The value is allocated through Alloc (rebound to T), e.g. pool_allocator
+// from pool_allocator.hpp. The allocator is stored as an empty base, so a
+// stateless allocator adds nothing to the size of the wrapper.
+template <typename T, typename Alloc = std::allocator<T>>
 class recursive_wrapper
+    : private std::allocator_traits<Alloc>::template rebind_alloc<T>
 {
+    using allocator_base = typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+    using traits = std::allocator_traits<allocator_base>;
 
     T* p_;
 
+    // a moved from wrapper holds no value and gets a new one
     void assign(T const& rhs)
     {
-        this->get() = rhs;
+        if (p_) this->get() = rhs;
+        else p_ = create(rhs);
+    }
+
+    template <typename... Args>
+    T* create(Args &&... args)
+    {
+        allocator_base & alloc = *this;
+        T* p = traits::allocate(alloc, 1);
+        try
+        {
+            traits::construct(alloc, p, std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            traits::deallocate(alloc, p, 1);
+            throw;
+        }
+        return p;
     }
 
 public:
 
     using type = T;
+    using allocator_type = allocator_base;
 
     /**
      * Default constructor default initializes the internally stored value.
@@ -41,24 +68,34 @@ public:
      *         of type T.
      * @throws any exception thrown by the default constructur of T.
      */
-    recursive_wrapper() : p_(new T) {};
+    recursive_wrapper() : p_(create()) {};
 
-    ~recursive_wrapper() noexcept { delete p_; };
+    ~recursive_wrapper() noexcept
+    {
+        if (p_)
+        {
+            allocator_base & alloc = *this;
+            traits::destroy(alloc, p_);
+            traits::deallocate(alloc, p_, 1);
+        }
+    };
 
     recursive_wrapper(recursive_wrapper const& operand)
-        : p_(new T(operand.get())) {}
+        : allocator_base(traits::select_on_container_copy_construction(operand)),
+          p_(create(operand.get())) {}
 
     recursive_wrapper(T const& operand)
-        : p_(new T(operand)) {}
+        : p_(create(operand)) {}
 
     recursive_wrapper(recursive_wrapper && operand)
-        : p_(operand.p_)
+        : allocator_base(std::move(static_cast<allocator_base &>(operand))),
+          p_(operand.p_)
     {
         operand.p_ = nullptr;
     }
 
     recursive_wrapper(T && operand)
-        : p_(new T(std::move(operand))) {}
+        : p_(create(std::move(operand))) {}
 
     inline recursive_wrapper & operator=(recursive_wrapper const& rhs)
     {
@@ -74,6 +111,8 @@ public:
 
     inline void swap(recursive_wrapper & operand) noexcept
     {
+        using std::swap;
+        swap(static_cast<allocator_base &>(*this), static_cast<allocator_base &>(operand));
         T* temp = operand.p_;
         operand.p_ = p_;
         p_ = temp;
@@ -87,7 +126,8 @@ public:
 
     recursive_wrapper & operator=(T && rhs)
     {
-        get() = std::move(rhs);
+        if (p_) get() = std::move(rhs);
+        else p_ = create(std::move(rhs));
         return *this;
     }
 
@@ -111,10 +151,12 @@ public:
 
     operator T &() { return this->get(); }
 
+    allocator_type get_allocator() const { return *this; }
+
 }; // class recursive_wrapper
 
-template <typename T>
-inline void swap(recursive_wrapper<T> & lhs, recursive_wrapper<T> & rhs) noexcept
+template <typename T, typename Alloc>
+inline void swap(recursive_wrapper<T, Alloc> & lhs, recursive_wrapper<T, Alloc> & rhs) noexcept
 {
     lhs.swap(rhs);
 }
@@ -0,0 +1,75 @@
+#ifndef MAPBOX_UTIL_REF_COUNT_HPP
+#define MAPBOX_UTIL_REF_COUNT_HPP
+
+#include <atomic>
+#include <cstddef> // size_t
+
+// Reference count policies for the shared, copy-on-write types.
+//
+// atomic_ref_count can be shared between threads. nonatomic_ref_count
+// is cheaper but every copy of a value must stay on one thread, e.g. in a
+// per-worker arena.
+
+namespace mapbox { namespace util {
+
+class atomic_ref_count
+{
+public:
+    atomic_ref_count() noexcept
+        : count_(1) {}
+
+    atomic_ref_count(atomic_ref_count const&) = delete;
+    atomic_ref_count& operator=(atomic_ref_count const&) = delete;
+
+    void increment() noexcept
+    {
+        count_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // returns true when the last reference is gone
+    bool decrement() noexcept
+    {
+        return count_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+
+    std::size_t use_count() const noexcept
+    {
+        return count_.load(std::memory_order_acquire);
+    }
+
+private:
+    std::atomic<std::size_t> count_;
+};
+
+class nonatomic_ref_count
+{
+public:
+    nonatomic_ref_count() noexcept
+        : count_(1) {}
+
+    nonatomic_ref_count(nonatomic_ref_count const&) = delete;
+    nonatomic_ref_count& operator=(nonatomic_ref_count const&) = delete;
+
+    void increment() noexcept
+    {
+        ++count_;
+    }
+
+    // returns true when the last reference is gone
+    bool decrement() noexcept
+    {
+        return --count_ == 0;
+    }
+
+    std::size_t use_count() const noexcept
+    {
+        return count_;
+    }
+
+private:
+    std::size_t count_;
+};
+
+}}
+
+#endif // MAPBOX_UTIL_REF_COUNT_HPP
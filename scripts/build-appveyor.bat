@@ -30,3 +30,6 @@ build\variant.sln ^
 /p:Platform=%MSBUILD_PLATFORM%
 
 build\"%configuration%"\tests.exe
+IF %ERRORLEVEL% NEQ 0 EXIT /B %ERRORLEVEL%
+
+build\"%configuration%"\dispatch_profile_tests.exe
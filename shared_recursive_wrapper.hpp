@@ -0,0 +1,203 @@
+#ifndef MAPBOX_UTIL_SHARED_RECURSIVE_WRAPPER_HPP
+#define MAPBOX_UTIL_SHARED_RECURSIVE_WRAPPER_HPP
+
+#include <cassert>
+#include <cstddef> // size_t
+#include <type_traits>
+#include <utility>
+
+#include "ref_count.hpp"
+#include "variant.hpp"
+
+// shared_recursive_wrapper<T, RefCount> - a copy-on-write recursive_wrapper.
+//
+// Copies share the node, copying a tree is O(1) whatever its size. Visiting
+// never copies: visitors get a T const& whether the variant is const or
+// not. Mutable access (get() on the wrapper, or get<T>() on a non-const
+// variant) first clones the node if it is shared, so a change is never seen
+// through another copy; only the nodes on the path to the change are
+// cloned, the rest of the tree stays shared.
+//
+// RefCount is atomic_ref_count, which allows sharing trees between
+// threads, or nonatomic_ref_count (local_shared_recursive_wrapper) for
+// trees that stay on one thread.
+
+namespace mapbox { namespace util {
+
+template <typename T, typename RefCount = atomic_ref_count>
+class shared_recursive_wrapper
+{
+    struct node
+    {
+        RefCount count;
+        T value;
+
+        template <typename... Args>
+        explicit node(Args &&... args)
+            : value(std::forward<Args>(args)...) {}
+    };
+
+    node* p_;
+
+    void release() noexcept
+    {
+        if (p_ && p_->count.decrement())
+        {
+            delete p_;
+        }
+    }
+
+    // makes this the only owner of the node
+    void detach()
+    {
+        assert(p_);
+        if (p_->count.use_count() != 1)
+        {
+            node* copy = new node(static_cast<T const&>(p_->value));
+            release();
+            p_ = copy;
+        }
+    }
+
+public:
+
+    using type = T;
+
+    shared_recursive_wrapper() : p_(new node()) {}
+
+    ~shared_recursive_wrapper() noexcept { release(); }
+
+    shared_recursive_wrapper(shared_recursive_wrapper const& operand) noexcept
+        : p_(operand.p_)
+    {
+        if (p_) p_->count.increment();
+    }
+
+    shared_recursive_wrapper(T const& operand)
+        : p_(new node(operand)) {}
+
+    shared_recursive_wrapper(shared_recursive_wrapper && operand) noexcept
+        : p_(operand.p_)
+    {
+        operand.p_ = nullptr;
+    }
+
+    shared_recursive_wrapper(T && operand)
+        : p_(new node(std::move(operand))) {}
+
+    shared_recursive_wrapper & operator=(shared_recursive_wrapper const& rhs) noexcept
+    {
+        if (p_ != rhs.p_)
+        {
+            if (rhs.p_) rhs.p_->count.increment();
+            release();
+            p_ = rhs.p_;
+        }
+        return *this;
+    }
+
+    shared_recursive_wrapper & operator=(shared_recursive_wrapper && rhs) noexcept
+    {
+        swap(rhs);
+        return *this;
+    }
+
+    // assigns in place if the node isn't shared
+    shared_recursive_wrapper & operator=(T const& rhs)
+    {
+        if (unique()) p_->value = rhs;
+        else *this = shared_recursive_wrapper(rhs);
+        return *this;
+    }
+
+    shared_recursive_wrapper & operator=(T && rhs)
+    {
+        if (unique()) p_->value = std::move(rhs);
+        else *this = shared_recursive_wrapper(std::move(rhs));
+        return *this;
+    }
+
+    void swap(shared_recursive_wrapper & operand) noexcept
+    {
+        node* temp = operand.p_;
+        operand.p_ = p_;
+        p_ = temp;
+    }
+
+    // clones a shared node first
+    T & get()
+    {
+        detach();
+        return p_->value;
+    }
+
+    T const& get() const
+    {
+        assert(p_);
+        return p_->value;
+    }
+
+    T* get_pointer() { return &get(); }
+
+    const T* get_pointer() const { return p_ ? &p_->value : nullptr; }
+
+    operator T const&() const { return this->get(); }
+
+    operator T &() { return this->get(); }
+
+    // true if no other wrapper shares the node
+    bool unique() const noexcept
+    {
+        return p_ && p_->count.use_count() == 1;
+    }
+
+    std::size_t use_count() const noexcept
+    {
+        return p_ ? p_->count.use_count() : 0;
+    }
+
+}; // class shared_recursive_wrapper
+
+template <typename T, typename RefCount>
+inline void swap(shared_recursive_wrapper<T, RefCount> & lhs, shared_recursive_wrapper<T, RefCount> & rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+template <typename T>
+using local_shared_recursive_wrapper = shared_recursive_wrapper<T, nonatomic_ref_count>;
+
+namespace detail {
+
+template <typename T, typename RefCount>
+struct boxed_type<shared_recursive_wrapper<T, RefCount>>
+{
+    using type = T;
+};
+
+// visitors never get mutable access, which would clone shared nodes
+template <typename T, typename RefCount>
+struct unwrapper<shared_recursive_wrapper<T, RefCount>>
+{
+    static T const& apply_const(shared_recursive_wrapper<T, RefCount> const& obj)
+    {
+        return obj.get();
+    }
+    static T const& apply(shared_recursive_wrapper<T, RefCount> const& obj)
+    {
+        return obj.get();
+    }
+    static T const& apply_rvalue(shared_recursive_wrapper<T, RefCount> const& obj)
+    {
+        return obj.get();
+    }
+};
+
+} // namespace detail
+
+template <typename T, typename RefCount>
+struct is_trivially_relocatable<shared_recursive_wrapper<T, RefCount>> : std::true_type {};
+
+}}
+
+#endif // MAPBOX_UTIL_SHARED_RECURSIVE_WRAPPER_HPP
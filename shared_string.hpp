@@ -0,0 +1,174 @@
+#ifndef MAPBOX_UTIL_SHARED_STRING_HPP
+#define MAPBOX_UTIL_SHARED_STRING_HPP
+
+#include <algorithm> // min
+#include <cstddef> // size_t
+#include <cstring> // memcpy, memcmp, strlen
+#include <new>
+#include <string>
+#include <type_traits>
+
+#include "ref_count.hpp"
+#include "string_operators.hpp"
+#include "variant.hpp"
+
+// basic_shared_string<RefCount> - an immutable, reference counted string
+// meant as a variant alternative. Copies share the chars and only touch
+// the count; the count and the chars live in one allocation. The empty
+// string doesn't allocate.
+//
+// RefCount is atomic_ref_count (shared_string) or nonatomic_ref_count
+// (local_shared_string) for values that never leave one thread.
+
+namespace mapbox { namespace util {
+
+template <typename RefCount>
+class basic_shared_string : public detail::string_operators<basic_shared_string<RefCount>>
+{
+    struct rep
+    {
+        RefCount count;
+        std::size_t size;
+
+        char* chars() noexcept
+        {
+            return reinterpret_cast<char*>(this + 1);
+        }
+    };
+
+    rep* rep_;
+
+    VARIANT_INLINE static rep* make_rep(char const* str, std::size_t size)
+    {
+        if (size == 0) return nullptr;
+        rep* r = new (::operator new(sizeof(rep) + size + 1)) rep();
+        r->size = size;
+        std::memcpy(r->chars(), str, size);
+        r->chars()[size] = '\0';
+        return r;
+    }
+
+    VARIANT_INLINE void release() noexcept
+    {
+        if (rep_ != nullptr && rep_->count.decrement())
+        {
+            rep_->~rep();
+            ::operator delete(rep_);
+        }
+    }
+
+public:
+
+    VARIANT_INLINE basic_shared_string() noexcept
+        : rep_(nullptr) {}
+
+    VARIANT_INLINE basic_shared_string(char const* str)
+        : rep_(make_rep(str, std::strlen(str))) {}
+
+    VARIANT_INLINE basic_shared_string(char const* str, std::size_t size)
+        : rep_(make_rep(str, size)) {}
+
+    VARIANT_INLINE basic_shared_string(std::string const& str)
+        : rep_(make_rep(str.data(), str.size())) {}
+
+    VARIANT_INLINE basic_shared_string(basic_shared_string const& other) noexcept
+        : rep_(other.rep_)
+    {
+        if (rep_ != nullptr) rep_->count.increment();
+    }
+
+    VARIANT_INLINE basic_shared_string(basic_shared_string && other) noexcept
+        : rep_(other.rep_)
+    {
+        other.rep_ = nullptr;
+    }
+
+    VARIANT_INLINE basic_shared_string& operator=(basic_shared_string const& other) noexcept
+    {
+        if (rep_ != other.rep_)
+        {
+            if (other.rep_ != nullptr) other.rep_->count.increment();
+            release();
+            rep_ = other.rep_;
+        }
+        return *this;
+    }
+
+    VARIANT_INLINE basic_shared_string& operator=(basic_shared_string && other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            rep_ = other.rep_;
+            other.rep_ = nullptr;
+        }
+        return *this;
+    }
+
+    ~basic_shared_string() noexcept
+    {
+        release();
+    }
+
+    VARIANT_INLINE std::size_t size() const noexcept
+    {
+        return rep_ != nullptr ? rep_->size : 0;
+    }
+
+    VARIANT_INLINE bool empty() const noexcept
+    {
+        return rep_ == nullptr;
+    }
+
+    VARIANT_INLINE char const* data() const noexcept
+    {
+        return rep_ != nullptr ? rep_->chars() : "";
+    }
+
+    VARIANT_INLINE char const* c_str() const noexcept
+    {
+        return data();
+    }
+
+    VARIANT_INLINE std::string str() const
+    {
+        return std::string(data(), size());
+    }
+
+    // number of strings sharing the chars, 0 for the empty string
+    VARIANT_INLINE std::size_t use_count() const noexcept
+    {
+        return rep_ != nullptr ? rep_->count.use_count() : 0;
+    }
+
+    // true if both share the same chars, equal strings built separately
+    // don't
+    VARIANT_INLINE bool shares(basic_shared_string const& other) const noexcept
+    {
+        return rep_ == other.rep_;
+    }
+
+    VARIANT_INLINE int compare(char const* str, std::size_t size) const
+    {
+        std::size_t const lhs_size = this->size();
+        int result = std::memcmp(data(), str, std::min(lhs_size, size));
+        if (result != 0) return result;
+        return lhs_size < size ? -1 : (lhs_size > size ? 1 : 0);
+    }
+
+    VARIANT_INLINE int compare(basic_shared_string const& other) const
+    {
+        return shares(other) ? 0 : compare(other.data(), other.size());
+    }
+};
+
+using shared_string = basic_shared_string<atomic_ref_count>;
+using local_shared_string = basic_shared_string<nonatomic_ref_count>;
+
+// a single owning pointer
+template <typename RefCount>
+struct is_trivially_relocatable<basic_shared_string<RefCount>> : std::true_type {};
+
+}}
+
+#endif  // MAPBOX_UTIL_SHARED_STRING_HPP
@@ -0,0 +1,211 @@
+#ifndef MAPBOX_UTIL_SMALL_STRING_HPP
+#define MAPBOX_UTIL_SMALL_STRING_HPP
+
+#include <algorithm> // min
+#include <cstddef> // size_t
+#include <cstring> // memcpy, memcmp, strlen
+#include <string>
+#include <type_traits>
+
+#include "string_operators.hpp"
+#include "variant.hpp"
+
+// basic_small_string<Capacity> - an immutable string meant as a variant
+// alternative. Strings of up to Capacity chars are kept inline, without
+// any allocation; longer ones spill to the heap.
+//
+// The last byte of the inline buffer holds Capacity - size, which becomes
+// the terminating zero when the string is full, or heap_flag when the
+// chars live on the heap. Copying a short string is a copy of the object
+// bytes, the same on every standard library. small_string (23 chars) is
+// 24 bytes on 64 bit platforms.
+
+namespace mapbox { namespace util {
+
+template <std::size_t Capacity>
+class basic_small_string : public detail::string_operators<basic_small_string<Capacity>>
+{
+    static_assert(Capacity >= sizeof(char*) + sizeof(std::size_t), "small string capacity must cover the heap representation");
+    static_assert(Capacity < 0xff, "small string capacity must fit into the tag byte");
+
+    static constexpr unsigned char heap_flag = 0xff;
+
+    // inline chars, or the heap pointer followed by the size
+    alignas(char*) char chars_[Capacity + 1];
+
+    VARIANT_INLINE unsigned char tag() const
+    {
+        return static_cast<unsigned char>(chars_[Capacity]);
+    }
+
+    VARIANT_INLINE char* heap_data() const
+    {
+        char* data;
+        std::memcpy(&data, chars_, sizeof(data));
+        return data;
+    }
+
+    VARIANT_INLINE std::size_t heap_size() const
+    {
+        std::size_t size;
+        std::memcpy(&size, chars_ + sizeof(char*), sizeof(size));
+        return size;
+    }
+
+    VARIANT_INLINE void init(char const* str, std::size_t size)
+    {
+        if (size <= Capacity)
+        {
+            std::memcpy(chars_, str, size);
+            chars_[size] = '\0';
+            chars_[Capacity] = static_cast<char>(Capacity - size);
+        }
+        else
+        {
+            char* data = new char[size + 1];
+            std::memcpy(data, str, size);
+            data[size] = '\0';
+            std::memcpy(chars_, &data, sizeof(data));
+            std::memcpy(chars_ + sizeof(char*), &size, sizeof(size));
+            chars_[Capacity] = static_cast<char>(heap_flag);
+        }
+    }
+
+    VARIANT_INLINE void reset()
+    {
+        chars_[0] = '\0';
+        chars_[Capacity] = static_cast<char>(Capacity);
+    }
+
+    VARIANT_INLINE void destroy()
+    {
+        if (!is_inline())
+        {
+            delete[] heap_data();
+        }
+    }
+
+public:
+
+    static constexpr std::size_t capacity = Capacity;
+
+    VARIANT_INLINE basic_small_string() noexcept
+    {
+        reset();
+    }
+
+    VARIANT_INLINE basic_small_string(char const* str)
+    {
+        init(str, std::strlen(str));
+    }
+
+    VARIANT_INLINE basic_small_string(char const* str, std::size_t size)
+    {
+        init(str, size);
+    }
+
+    VARIANT_INLINE basic_small_string(std::string const& str)
+    {
+        init(str.data(), str.size());
+    }
+
+    VARIANT_INLINE basic_small_string(basic_small_string const& other)
+    {
+        if (other.is_inline())
+        {
+            std::memcpy(chars_, other.chars_, sizeof(chars_));
+        }
+        else
+        {
+            init(other.heap_data(), other.heap_size());
+        }
+    }
+
+    VARIANT_INLINE basic_small_string(basic_small_string && other) noexcept
+    {
+        std::memcpy(chars_, other.chars_, sizeof(chars_));
+        other.reset();
+    }
+
+    VARIANT_INLINE basic_small_string& operator=(basic_small_string const& other)
+    {
+        if (this != &other)
+        {
+            basic_small_string temp(other);
+            *this = std::move(temp);
+        }
+        return *this;
+    }
+
+    VARIANT_INLINE basic_small_string& operator=(basic_small_string && other) noexcept
+    {
+        if (this != &other)
+        {
+            destroy();
+            std::memcpy(chars_, other.chars_, sizeof(chars_));
+            other.reset();
+        }
+        return *this;
+    }
+
+    ~basic_small_string() noexcept
+    {
+        destroy();
+    }
+
+    VARIANT_INLINE bool is_inline() const
+    {
+        return tag() != heap_flag;
+    }
+
+    VARIANT_INLINE std::size_t size() const
+    {
+        return is_inline() ? Capacity - tag() : heap_size();
+    }
+
+    VARIANT_INLINE bool empty() const
+    {
+        return size() == 0;
+    }
+
+    VARIANT_INLINE char const* data() const
+    {
+        return is_inline() ? chars_ : heap_data();
+    }
+
+    VARIANT_INLINE char const* c_str() const
+    {
+        return data();
+    }
+
+    VARIANT_INLINE std::string str() const
+    {
+        return std::string(data(), size());
+    }
+
+    VARIANT_INLINE int compare(char const* str, std::size_t size) const
+    {
+        std::size_t const lhs_size = this->size();
+        int result = std::memcmp(data(), str, std::min(lhs_size, size));
+        if (result != 0) return result;
+        return lhs_size < size ? -1 : (lhs_size > size ? 1 : 0);
+    }
+
+    VARIANT_INLINE int compare(basic_small_string const& other) const
+    {
+        return compare(other.data(), other.size());
+    }
+};
+
+template <std::size_t Capacity>
+constexpr std::size_t basic_small_string<Capacity>::capacity;
+
+using small_string = basic_small_string<23>;
+
+// no pointers into itself, heap chars are owned through a plain pointer
+template <std::size_t Capacity>
+struct is_trivially_relocatable<basic_small_string<Capacity>> : std::true_type {};
+
+}}
+
+#endif  // MAPBOX_UTIL_SMALL_STRING_HPP
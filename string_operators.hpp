@@ -0,0 +1,73 @@
+#ifndef MAPBOX_UTIL_STRING_OPERATORS_HPP
+#define MAPBOX_UTIL_STRING_OPERATORS_HPP
+
+#include <cstring> // strlen
+#include <iosfwd>
+#include <string>
+
+#include "variant.hpp"
+
+// Comparison and stream operators shared by the string alternatives
+// (small_string.hpp, shared_string.hpp). A string derives from
+// detail::string_operators<String> and provides data(), size() and
+// compare(char const*, size_t) / compare(String const&); the operators are
+// found by argument dependent lookup, so variant::operator== and operator<
+// use them as well.
+
+namespace mapbox { namespace util { namespace detail {
+
+template <typename String>
+class string_operators
+{
+    friend VARIANT_INLINE bool operator==(String const& lhs, String const& rhs)
+    {
+        return lhs.size() == rhs.size() && lhs.compare(rhs) == 0;
+    }
+
+    friend VARIANT_INLINE bool operator!=(String const& lhs, String const& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    friend VARIANT_INLINE bool operator<(String const& lhs, String const& rhs)
+    {
+        return lhs.compare(rhs) < 0;
+    }
+
+    friend VARIANT_INLINE bool operator>(String const& lhs, String const& rhs)
+    {
+        return rhs < lhs;
+    }
+
+    friend VARIANT_INLINE bool operator<=(String const& lhs, String const& rhs)
+    {
+        return !(rhs < lhs);
+    }
+
+    friend VARIANT_INLINE bool operator>=(String const& lhs, String const& rhs)
+    {
+        return !(lhs < rhs);
+    }
+
+    friend VARIANT_INLINE bool operator==(String const& lhs, char const* rhs)
+    {
+        return lhs.compare(rhs, std::strlen(rhs)) == 0;
+    }
+
+    friend VARIANT_INLINE bool operator==(String const& lhs, std::string const& rhs)
+    {
+        return lhs.compare(rhs.data(), rhs.size()) == 0;
+    }
+
+    template <typename Traits>
+    friend VARIANT_INLINE std::basic_ostream<char, Traits>&
+    operator<<(std::basic_ostream<char, Traits>& out, String const& rhs)
+    {
+        out.write(rhs.data(), static_cast<std::streamsize>(rhs.size()));
+        return out;
+    }
+};
+
+}}}
+
+#endif // MAPBOX_UTIL_STRING_OPERATORS_HPP
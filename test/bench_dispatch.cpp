@@ -0,0 +1,132 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/timer/timer.hpp>
+
+#include "variant.hpp"
+
+#define NUM_SAMPLES 3
+
+using namespace mapbox;
+
+namespace test {
+
+template <std::size_t I>
+struct alt
+{
+    std::uint32_t value;
+};
+
+using variant3 = util::variant<alt<0>, alt<1>, alt<2>>;
+
+using variant8 = util::variant<alt<0>, alt<1>, alt<2>, alt<3>, alt<4>, alt<5>, alt<6>, alt<7>>;
+
+using variant20 = util::variant<alt<0>, alt<1>, alt<2>, alt<3>, alt<4>, alt<5>, alt<6>, alt<7>,
+                                alt<8>, alt<9>, alt<10>, alt<11>, alt<12>, alt<13>, alt<14>,
+                                alt<15>, alt<16>, alt<17>, alt<18>, alt<19>>;
+
+template <typename Strategy>
+struct sum : util::static_visitor<std::uint64_t>
+{
+    using dispatch_strategy = Strategy;
+
+    template <std::size_t I>
+    std::uint64_t operator()(alt<I> const& a) const
+    {
+        return a.value * (I + 1);
+    }
+};
+
+template <std::size_t I, typename V>
+struct filler
+{
+    static void apply(std::size_t which, std::uint32_t value, V & v)
+    {
+        if (which == I) v = alt<I>{value};
+        else filler<I - 1, V>::apply(which, value, v);
+    }
+};
+
+template <typename V>
+struct filler<0, V>
+{
+    static void apply(std::size_t, std::uint32_t value, V & v)
+    {
+        v = alt<0>{value};
+    }
+};
+
+// uniform == false: 80% of the values hold the last alternative
+template <typename V, std::size_t N>
+std::vector<V> make_data(std::size_t runs, bool uniform)
+{
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<std::size_t> type_dist(0, N - 1);
+    std::uniform_int_distribution<std::uint32_t> value_dist(0, 1000);
+    std::bernoulli_distribution hot(0.8);
+    std::vector<V> data(runs);
+    for (auto & v : data)
+    {
+        std::size_t which = (!uniform && hot(gen)) ? N - 1 : type_dist(gen);
+        filler<N - 1, V>::apply(which, value_dist(gen), v);
+    }
+    return data;
+}
+
+template <typename Strategy, typename V>
+std::uint64_t run(std::vector<V> const& data, char const* name)
+{
+    std::uint64_t total = 0;
+    std::cerr << "  " << name << ": ";
+    boost::timer::auto_cpu_timer t;
+    for (std::size_t j = 0; j < NUM_SAMPLES; ++j)
+    {
+        for (auto const& v : data)
+        {
+            total += util::apply_visitor(sum<Strategy>(), v);
+        }
+    }
+    return total;
+}
+
+template <typename V, std::size_t N>
+void run_all(std::size_t runs, bool uniform)
+{
+    std::cerr << N << " alternatives, " << (uniform ? "uniform" : "skewed") << " distribution" << std::endl;
+    auto data = make_data<V, N>(runs, uniform);
+    std::uint64_t t0 = run<util::linear_dispatch>(data, "linear");
+    std::uint64_t t1 = run<util::binary_search_dispatch>(data, "binary search");
+    std::uint64_t t2 = run<util::table_dispatch>(data, "table");
+    std::uint64_t t3 = run<util::priority_dispatch<alt<N - 1>>>(data, "priority");
+    if (t0 != t1 || t0 != t2 || t0 != t3)
+    {
+        std::cerr << "strategies disagree: " << t0 << " " << t1 << " " << t2 << " " << t3 << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+} // namespace test
+
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        std::cerr << "Usage:" << argv[0] << " <num-runs>" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::size_t NUM_RUNS = static_cast<std::size_t>(std::stol(argv[1]));
+
+    for (bool uniform : {true, false})
+    {
+        test::run_all<test::variant3, 3>(NUM_RUNS, uniform);
+        test::run_all<test::variant8, 8>(NUM_RUNS, uniform);
+        test::run_all<test::variant20, 20>(NUM_RUNS, uniform);
+    }
+
+    return EXIT_SUCCESS;
+}
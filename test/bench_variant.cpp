@@ -121,6 +121,28 @@ void run_variant_test(std::size_t runs)
     }
 }
 
+// same as run_variant_test but drains the holder, visiting rvalue variants
+// so the alternatives are moved out instead of copied
+void run_variant_move_test(std::size_t runs)
+{
+    test::Holder<util::variant<int, double, std::string>> h;
+    h.data.reserve(runs);
+    for (std::size_t i = 0; i < runs; ++i)
+    {
+        h.append_move(std::string(TEXT_SHORT));
+        h.append_move(std::string(TEXT_LONG));
+        h.append_move(123);
+        h.append_move(3.14159);
+    }
+
+    util::variant<int, double, std::string> v;
+    for (auto & v2 : h.data)
+    {
+        dummy2<util::variant<int, double, std::string>> d(v);
+        util::apply_visitor(d, std::move(v2));
+    }
+}
+
 int main(int argc, char** argv)
 {
     if (argc != 2)
@@ -144,6 +166,11 @@ int main(int argc, char** argv)
             boost::timer::auto_cpu_timer t;
             run_variant_test(NUM_RUNS);
         }
+        {
+            std::cerr << "custom variant (move): ";
+            boost::timer::auto_cpu_timer t;
+            run_variant_move_test(NUM_RUNS);
+        }
         {
             std::cerr << "boost variant: ";
             boost::timer::auto_cpu_timer t;
@@ -167,6 +194,19 @@ int main(int argc, char** argv)
             std::for_each(tg.begin(), tg.end(), [](value_type & t) {if (t->joinable()) t->join();});
         }
 
+        {
+            typedef std::vector<std::unique_ptr<std::thread>> thread_group;
+            typedef thread_group::value_type value_type;
+            thread_group tg;
+            std::cerr << "custom variant (move): ";
+            boost::timer::auto_cpu_timer timer;
+            for (std::size_t i = 0; i < THREADS; ++i)
+            {
+                tg.emplace_back(new std::thread(run_variant_move_test, NUM_RUNS));
+            }
+            std::for_each(tg.begin(), tg.end(), [](value_type & t) {if (t->joinable()) t->join();});
+        }
+
         {
             typedef std::vector<std::unique_ptr<std::thread>> thread_group;
             typedef thread_group::value_type value_type;
@@ -0,0 +1,21 @@
+
+#include <shared_recursive_wrapper.hpp>
+#include <tree_traversal.hpp>
+#include <variant.hpp>
+
+// Checks that a tree with shared nodes can't be walked as non-const: the
+// children of shared nodes would be skipped.
+
+struct node;
+
+using tree_type = mapbox::util::variant<int, mapbox::util::shared_recursive_wrapper<node>>;
+
+struct node
+{
+    tree_type child;
+};
+
+int main() {
+    tree_type tree(node{1});
+    mapbox::util::for_each_preorder(tree, [](tree_type &) {});
+}
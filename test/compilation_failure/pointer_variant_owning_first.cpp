@@ -0,0 +1,17 @@
+
+#include <pointer_variant.hpp>
+
+#include <memory>
+
+// Checks that the first type in a pointer_variant can't be an owning
+// pointer: default constructed and moved from pointer_variants hold it as
+// null.
+
+struct node
+{
+    alignas(8) int value;
+};
+
+int main() {
+    mapbox::util::pointer_variant<std::unique_ptr<node>, int> x;
+}
@@ -0,0 +1,59 @@
+
+// VARIANT_PROFILE_DISPATCH changes the inline visit functions of variant,
+// so it has to be set for the whole program: this test is its own binary,
+// built with -DVARIANT_PROFILE_DISPATCH (see the Makefile) and linked with
+// the catch main from test/unit.cpp only.
+#ifndef VARIANT_PROFILE_DISPATCH
+#error "build with -DVARIANT_PROFILE_DISPATCH"
+#endif
+
+#include "catch.hpp"
+
+#include "variant.hpp"
+
+#include <cstdint>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace {
+
+struct profiled_visitor
+{
+    template <typename T>
+    void operator()(T const&) const {}
+};
+
+mapbox::util::dispatch_profile const* find_site(std::type_info const& visitor)
+{
+    for (auto site = mapbox::util::dispatch_profile::first(); site != nullptr; site = site->next())
+    {
+        if (site->visitor() == visitor)
+        {
+            return site;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+TEST_CASE( "dispatch profile records the type distribution of a visit site", "[visitor][profile]" ) {
+    using variant_type = mapbox::util::variant<bool, double, std::string>;
+    std::vector<variant_type> vec = {1.0, 2.0, 3.0, std::string("foo"), true, 4.0};
+    for (auto const& v : vec)
+    {
+        mapbox::util::apply_visitor(profiled_visitor(), v);
+    }
+    variant_type invalid{mapbox::util::no_init()};
+    REQUIRE_THROWS(mapbox::util::apply_visitor(profiled_visitor(), invalid));
+
+    auto site = find_site(typeid(profiled_visitor));
+    REQUIRE(site != nullptr);
+    REQUIRE(site->variant_type() == typeid(variant_type));
+    REQUIRE(site->size() == 3);
+    REQUIRE(site->alternative(1) == typeid(double));
+    REQUIRE(site->count(0) == 1);
+    REQUIRE(site->count(1) == 4);
+    REQUIRE(site->count(2) == 1);
+}
@@ -0,0 +1,95 @@
+#ifndef MAPBOX_UTIL_TEST_EXPRESSION_TREE_HPP
+#define MAPBOX_UTIL_TEST_EXPRESSION_TREE_HPP
+
+#include <utility>
+
+#include "recursive_traits.hpp"
+#include "variant.hpp"
+
+// The arithmetic tree used by the recursive variant tests.
+//
+// binary_op<Op, Tree> holds two Tree::expression operands, so each test
+// picks the variant and the wrapper it is about:
+//
+//     struct tree_traits;
+//
+//     template <typename Op>
+//     using binary_op = expression_tree::binary_op<Op, tree_traits>;
+//
+//     struct tree_traits
+//     {
+//         using expression = variant<int,
+//                                    recursive_wrapper<binary_op<add>>,
+//                                    recursive_wrapper<binary_op<sub>>>;
+//     };
+//
+// calculator evaluates trees of ints, and recursive_children lists the
+// operands of a binary_op for recursive_traits.hpp.
+
+namespace expression_tree {
+
+struct add;
+struct sub;
+
+template <typename Op, typename Tree>
+struct binary_op
+{
+    using expression = typename Tree::expression;
+
+    expression left;
+    expression right;
+
+    binary_op(expression && lhs, expression && rhs)
+        : left(std::move(lhs)), right(std::move(rhs)) {}
+
+    binary_op(expression const& lhs, expression const& rhs)
+        : left(lhs), right(rhs) {}
+};
+
+struct calculator : mapbox::util::static_visitor<int>
+{
+    int operator()(int value) const
+    {
+        return value;
+    }
+
+    template <typename Tree>
+    int operator()(binary_op<add, Tree> const& binary) const
+    {
+        return mapbox::util::apply_visitor(*this, binary.left)
+            + mapbox::util::apply_visitor(*this, binary.right);
+    }
+
+    template <typename Tree>
+    int operator()(binary_op<sub, Tree> const& binary) const
+    {
+        return mapbox::util::apply_visitor(*this, binary.left)
+            - mapbox::util::apply_visitor(*this, binary.right);
+    }
+};
+
+} // namespace expression_tree
+
+namespace mapbox { namespace util {
+
+template <typename Op, typename Tree>
+struct recursive_children<expression_tree::binary_op<Op, Tree>>
+{
+    template <typename Node, typename F>
+    static void for_each(Node & node, F && f)
+    {
+        f(node.left);
+        f(node.right);
+    }
+
+    // operands are filled in by iterative_copy()
+    static expression_tree::binary_op<Op, Tree> copy_node(expression_tree::binary_op<Op, Tree> const&)
+    {
+        using expression = typename Tree::expression;
+        return expression_tree::binary_op<Op, Tree>(expression(), expression());
+    }
+};
+
+}}
+
+#endif // MAPBOX_UTIL_TEST_EXPRESSION_TREE_HPP
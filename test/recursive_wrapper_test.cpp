@@ -4,9 +4,12 @@
 #include <string>
 #include <typeinfo>
 #include <utility>
+#include <vector>
 
 #include <boost/timer/timer.hpp>
 
+#include "flat_tree.hpp"
+#include "postfix_program.hpp"
 #include "variant.hpp"
 
 using namespace mapbox;
@@ -100,8 +103,96 @@ public:
 
 };
 
+// the same expression with the nodes in a flat_tree
+struct flat_add
+{
+    util::flat_index left;
+    util::flat_index right;
+};
+
+struct flat_sub
+{
+    util::flat_index left;
+    util::flat_index right;
+};
+
+using flat_expression = util::variant<int, flat_add, flat_sub>;
+
+struct flat_calculator
+{
+    using result_type = int;
+
+    template <typename Visit>
+    int operator()(int value, Visit &) const
+    {
+        return value;
+    }
+
+    template <typename Visit>
+    int operator()(flat_add const& binary, Visit & visit) const
+    {
+        return visit(binary.left) + visit(binary.right);
+    }
+
+    template <typename Visit>
+    int operator()(flat_sub const& binary, Visit & visit) const
+    {
+        return visit(binary.left) - visit(binary.right);
+    }
+};
+
+// the same expression compiled to a postfix_program
+enum class opcode
+{
+    add,
+    sub
+};
+
+using program = util::postfix_program<int, opcode>;
+
+struct compile_rules
+{
+    void operator()(int value, program & p) const
+    {
+        p.push(value);
+    }
+
+    void operator()(binary_op<add> const&, program & p) const
+    {
+        p.apply(opcode::add, 2);
+    }
+
+    void operator()(binary_op<sub> const&, program & p) const
+    {
+        p.apply(opcode::sub, 2);
+    }
+};
+
+struct program_calculator
+{
+    int operator()(opcode op, int const* args, std::size_t) const
+    {
+        return op == opcode::add ? args[0] + args[1] : args[0] - args[1];
+    }
+};
+
 } // namespace test
 
+namespace mapbox { namespace util {
+
+template <typename Op>
+struct recursive_children<test::binary_op<Op>>
+{
+    template <typename Node, typename F>
+    static void for_each(Node & node, F && f)
+    {
+        f(node.left);
+        f(node.right);
+    }
+};
+
+}}
+
 int main(int argc, char** argv)
 {
     if (argc != 2)
@@ -127,6 +218,35 @@ int main(int argc, char** argv)
     }
     std::cerr << "total=" << total << std::endl;
 
+    util::flat_tree<test::flat_expression> flat;
+    util::flat_index flat_sum = flat.add(test::flat_add{flat.add(2), flat.add(3)});
+    flat.add(test::flat_sub{flat_sum, flat.add(4)});
+
+    int flat_total = 0;
+    {
+        std::cerr << "flat_tree: ";
+        boost::timer::auto_cpu_timer t;
+        for (std::size_t i = 0; i < NUM_ITER; ++i)
+        {
+            flat_total += flat.visit(test::flat_calculator());
+        }
+    }
+    std::cerr << "total=" << flat_total << std::endl;
+
+    test::program compiled = util::compile_postfix<int, test::opcode>(result, test::compile_rules());
+    std::vector<int> stack;
+
+    int compiled_total = 0;
+    {
+        std::cerr << "postfix_program: ";
+        boost::timer::auto_cpu_timer t;
+        for (std::size_t i = 0; i < NUM_ITER; ++i)
+        {
+            compiled_total += compiled.evaluate(test::program_calculator(), stack);
+        }
+    }
+    std::cerr << "total=" << compiled_total << std::endl;
+
     std::cerr << util::apply_visitor(test::to_string(), result) << "=" << util::apply_visitor(test::calculator(), result) << std::endl;
 
     return EXIT_SUCCESS;
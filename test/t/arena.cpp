@@ -0,0 +1,145 @@
+#include "catch.hpp"
+#include "expression_tree.hpp"
+
+#include "arena.hpp"
+#include "variant.hpp"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace {
+
+using mapbox::util::arena_recursive_wrapper;
+using mapbox::util::arena_scope;
+using mapbox::util::monotonic_arena;
+
+using expression_tree::add;
+using expression_tree::calculator;
+using expression_tree::sub;
+
+struct tree_traits;
+
+template <typename Op>
+using binary_op = expression_tree::binary_op<Op, tree_traits>;
+
+struct tree_traits
+{
+    using expression = mapbox::util::variant<int,
+                                             arena_recursive_wrapper<binary_op<add>>,
+                                             arena_recursive_wrapper<binary_op<sub>>>;
+};
+
+using expression = tree_traits::expression;
+
+int destroyed = 0;
+
+// a leaf that counts its destruction
+struct tally
+{
+    ~tally()
+    {
+        ++destroyed;
+    }
+};
+
+struct counted_traits;
+
+using counted_op = expression_tree::binary_op<add, counted_traits>;
+
+struct counted_traits
+{
+    using expression = mapbox::util::variant<tally, arena_recursive_wrapper<counted_op>>;
+};
+
+using counted_expression = counted_traits::expression;
+
+// a node with a string is torn down normally
+struct named
+{
+    std::string name;
+};
+
+} // namespace
+
+namespace mapbox { namespace util {
+
+template <typename Op, typename Tree>
+struct is_arena_disposable<expression_tree::binary_op<Op, Tree>> : std::true_type {};
+
+}}
+
+TEST_CASE("monotonic_arena", "[arena]")
+{
+    monotonic_arena arena(1024);
+    auto address = [&arena](std::size_t size, std::size_t alignment) {
+        return reinterpret_cast<std::uintptr_t>(arena.allocate(size, alignment));
+    };
+    std::uintptr_t a = address(1, 1);
+    std::uintptr_t b = address(8, 8);
+    REQUIRE(b % 8 == 0);
+    REQUIRE(b > a);
+    REQUIRE(b - a <= 8);
+
+    // large allocations get their own block
+    REQUIRE(address(4000, 16) % 16 == 0);
+    REQUIRE(address(8, 8) - b == 8);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        REQUIRE(arena.allocate(24, 8) != nullptr);
+    }
+    arena.release();
+    REQUIRE(arena.allocate(8, 8) != nullptr);
+}
+
+TEST_CASE("arena_scope", "[arena]")
+{
+    REQUIRE(arena_scope::active() == nullptr);
+    REQUIRE_THROWS(arena_recursive_wrapper<int>(1));
+
+    monotonic_arena outer;
+    monotonic_arena inner;
+    {
+        arena_scope scope1(outer);
+        REQUIRE(arena_scope::active() == &outer);
+        {
+            arena_scope scope2(inner);
+            REQUIRE(arena_scope::active() == &inner);
+        }
+        REQUIRE(arena_scope::active() == &outer);
+    }
+    REQUIRE(arena_scope::active() == nullptr);
+}
+
+TEST_CASE("arena allocated recursive variant", "[arena]")
+{
+    monotonic_arena arena;
+    arena_scope scope(arena);
+    {
+        expression result(binary_op<sub>(binary_op<add>(1, 2), binary_op<sub>(10, 4)));
+        for (int i = 0; i < 10000; ++i)
+        {
+            result = binary_op<add>(std::move(result), 1);
+        }
+        REQUIRE(mapbox::util::apply_visitor(calculator(), result) == -3 + 10000);
+
+        expression copy(result);
+        REQUIRE(copy.is<binary_op<add>>());
+        REQUIRE(mapbox::util::apply_visitor(calculator(), copy) == -3 + 10000);
+    }
+
+    {
+        counted_expression counted(counted_op(counted_op(tally{}, tally{}), tally{}));
+        counted_expression copy(counted);
+        REQUIRE(copy.is<counted_op>());
+        destroyed = 0;
+    }
+    // arena nodes marked disposable are never destroyed, nor are their leaves
+    REQUIRE(destroyed == 0);
+
+    {
+        arena_recursive_wrapper<named> n(named{"not disposable"});
+        REQUIRE(n.get().name == "not disposable");
+    }
+}
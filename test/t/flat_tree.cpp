@@ -0,0 +1,207 @@
+#include "catch.hpp"
+
+#include "flat_tree.hpp"
+#include "variant.hpp"
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+using mapbox::util::flat_index;
+using mapbox::util::flat_tree;
+
+struct add
+{
+    flat_index left;
+    flat_index right;
+};
+
+struct sub
+{
+    flat_index left;
+    flat_index right;
+};
+
+using node = mapbox::util::variant<int, add, sub>;
+
+struct calculator
+{
+    using result_type = int;
+
+    template <typename Visit>
+    int operator()(int value, Visit &) const
+    {
+        return value;
+    }
+
+    template <typename Visit>
+    int operator()(add const& op, Visit & visit) const
+    {
+        return visit(op.left) + visit(op.right);
+    }
+
+    template <typename Visit>
+    int operator()(sub const& op, Visit & visit) const
+    {
+        return visit(op.left) - visit(op.right);
+    }
+};
+
+// result type deduced from the visitor
+struct to_string
+{
+    template <typename Visit>
+    std::string operator()(int value, Visit &) const
+    {
+        return std::to_string(value);
+    }
+
+    template <typename Visit>
+    std::string operator()(add const& op, Visit & visit) const
+    {
+        return "(" + visit(op.left) + " + " + visit(op.right) + ")";
+    }
+
+    template <typename Visit>
+    std::string operator()(sub const& op, Visit & visit) const
+    {
+        return "(" + visit(op.left) + " - " + visit(op.right) + ")";
+    }
+};
+
+// (1 + 2) - (10 - 4)
+flat_tree<node> make_tree()
+{
+    flat_tree<node> tree;
+    flat_index lhs = tree.add(add{tree.add(1), tree.add(2)});
+    flat_index rhs = tree.add(sub{tree.add(10), tree.add(4)});
+    tree.add(sub{lhs, rhs});
+    return tree;
+}
+
+} // namespace
+
+namespace mapbox { namespace util {
+
+template <>
+struct flat_children<add>
+{
+    template <typename F>
+    static void for_each(add const& node, F && f)
+    {
+        f(node.left);
+        f(node.right);
+    }
+};
+
+template <>
+struct flat_children<sub>
+{
+    template <typename F>
+    static void for_each(sub const& node, F && f)
+    {
+        f(node.left);
+        f(node.right);
+    }
+};
+
+}}
+
+TEST_CASE("flat_tree stores nodes contiguously", "[flat_tree]")
+{
+    flat_tree<node> tree = make_tree();
+    REQUIRE(tree.size() == 7);
+    REQUIRE(tree.root() == flat_index{6});
+    REQUIRE(tree[tree.root()].is<sub>());
+    REQUIRE(tree[flat_index{0}].get<int>() == 1);
+    REQUIRE(sizeof(flat_index) == 4);
+    REQUIRE(sizeof(node) == 12);
+
+    tree[flat_index{0}] = 5;
+    REQUIRE(tree.visit(calculator()) == 1);
+    tree.clear();
+    REQUIRE(tree.empty());
+    REQUIRE_THROWS(tree.root());
+    REQUIRE_THROWS(tree.visit(calculator()));
+}
+
+TEST_CASE("flat_tree visitor resolves child indices", "[flat_tree]")
+{
+    flat_tree<node> tree = make_tree();
+    REQUIRE(tree.visit(calculator()) == -3);
+    REQUIRE(tree.visit(to_string()) == "((1 + 2) - (10 - 4))");
+
+    // any node can serve as root
+    calculator calc;
+    REQUIRE(tree.visit(flat_index{2}, calc) == 3);
+}
+
+TEST_CASE("flat_tree of a long chain", "[flat_tree]")
+{
+    flat_tree<node> tree;
+    tree.reserve(2001);
+    flat_index sum = tree.add(0);
+    for (int i = 1; i <= 1000; ++i)
+    {
+        sum = tree.add(add{sum, tree.add(i)});
+    }
+    REQUIRE(tree.size() == 2001);
+    REQUIRE(tree.visit(calculator()) == 500500);
+}
+
+#ifndef VARIANT_NO_TRIVIALITY_TRAITS
+TEST_CASE("flat_tree of trivially copyable nodes can be copied as bytes", "[flat_tree]")
+{
+    REQUIRE(std::is_trivially_copyable<node>::value);
+
+    flat_tree<node> tree = make_tree();
+    std::vector<char> bytes(tree.size() * sizeof(node));
+    std::memcpy(bytes.data(), tree.data(), bytes.size());
+
+    std::vector<node> buffer(bytes.size() / sizeof(node), node(0));
+    std::memcpy(static_cast<void*>(buffer.data()), bytes.data(), bytes.size());
+    flat_tree<node> loaded(buffer.data(), buffer.size());
+    REQUIRE(loaded.size() == tree.size());
+    REQUIRE(loaded.visit(calculator()) == -3);
+
+    loaded.assign(buffer.data(), 1);
+    REQUIRE(loaded.visit(calculator()) == 1);
+}
+
+TEST_CASE("flat_tree rejects malformed nodes on load", "[flat_tree]")
+{
+    flat_tree<node> tree = make_tree();
+    std::vector<node> buffer(tree.data(), tree.data() + tree.size());
+
+    SECTION("type index out of range") {
+        // the type index follows the 8 bytes of add and sub
+        std::vector<unsigned char> bytes(sizeof(node));
+        std::memcpy(bytes.data(), static_cast<void const*>(&buffer[0]), bytes.size());
+        bytes[8] = 0x7f;
+        std::memcpy(static_cast<void*>(&buffer[0]), bytes.data(), bytes.size());
+        REQUIRE_THROWS(flat_tree<node>(buffer.data(), buffer.size()));
+    }
+
+    SECTION("child after its parent") {
+        buffer[2] = add{flat_index{0}, flat_index{3}};
+        REQUIRE_THROWS(flat_tree<node>(buffer.data(), buffer.size()));
+    }
+
+    SECTION("child referring to itself") {
+        buffer[6] = sub{flat_index{2}, flat_index{6}};
+        REQUIRE_THROWS(flat_tree<node>(buffer.data(), buffer.size()));
+    }
+
+    SECTION("child out of range") {
+        buffer[6] = sub{flat_index{2}, flat_index{100}};
+        flat_tree<node> loaded = make_tree();
+        REQUIRE_THROWS(loaded.assign(buffer.data(), buffer.size()));
+        // unchanged by the failed assign
+        REQUIRE(loaded.size() == 7);
+        REQUIRE(loaded.visit(calculator()) == -3);
+    }
+}
+#endif
@@ -0,0 +1,147 @@
+#include "catch.hpp"
+#include "expression_tree.hpp"
+
+#include "hash_cons.hpp"
+#include "shared_recursive_wrapper.hpp"
+#include "variant.hpp"
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+namespace {
+
+using mapbox::util::hash_combine;
+using mapbox::util::identity_equal;
+using mapbox::util::identity_hash;
+
+using expression_tree::add;
+using expression_tree::sub;
+
+struct tree_traits;
+
+template <typename Op>
+using binary_op = expression_tree::binary_op<Op, tree_traits>;
+
+struct tree_traits
+{
+    using expression = mapbox::util::variant<int,
+                                             std::string,
+                                             mapbox::util::shared_recursive_wrapper<binary_op<add>>,
+                                             mapbox::util::shared_recursive_wrapper<binary_op<sub>>>;
+};
+
+using expression = tree_traits::expression;
+
+struct op_hash
+{
+    template <typename Op>
+    std::size_t operator()(binary_op<Op> const& node) const
+    {
+        std::size_t seed = identity_hash(node.left);
+        hash_combine(seed, identity_hash(node.right));
+        return seed;
+    }
+};
+
+struct op_equal
+{
+    template <typename Op>
+    bool operator()(binary_op<Op> const& lhs, binary_op<Op> const& rhs) const
+    {
+        return identity_equal(lhs.left, rhs.left) && identity_equal(lhs.right, rhs.right);
+    }
+};
+
+template <typename Op>
+using factory_type = mapbox::util::hash_cons<binary_op<Op>, op_hash, op_equal>;
+
+template <typename Op>
+binary_op<Op> const* node_of(expression const& e)
+{
+    return &e.get<binary_op<Op>>();
+}
+
+} // namespace
+
+TEST_CASE("identity_hash and identity_equal", "[hash_cons]")
+{
+    expression a(1);
+    expression b(1);
+    expression c(std::string("1"));
+    REQUIRE(identity_equal(a, b));
+    REQUIRE(identity_hash(a) == identity_hash(b));
+    REQUIRE(!identity_equal(a, c));
+
+    // structurally equal but separate nodes differ
+    expression n1(binary_op<add>(1, 2));
+    expression n2(binary_op<add>(1, 2));
+    expression n3(n1);
+    REQUIRE(!identity_equal(n1, n2));
+    REQUIRE(identity_equal(n1, n3));
+    REQUIRE(identity_hash(n1) == identity_hash(n3));
+}
+
+TEST_CASE("hash_cons shares equal subtrees", "[hash_cons]")
+{
+    factory_type<add> sums;
+    factory_type<sub> differences;
+
+    // (x + 1) - (x + 1), twice
+    expression lhs = sums.make(binary_op<add>(std::string("x"), 1));
+    expression rhs = sums.make(binary_op<add>(std::string("x"), 1));
+    REQUIRE(node_of<add>(lhs) == node_of<add>(rhs));
+    REQUIRE(sums.size() == 1);
+
+    expression difference1 = differences.make(binary_op<sub>(lhs, rhs));
+    expression difference2 = differences.make(binary_op<sub>(sums.make(binary_op<add>(std::string("x"), 1)),
+                                                             sums.make(binary_op<add>(std::string("x"), 1))));
+    REQUIRE(sums.size() == 1);
+    REQUIRE(differences.size() == 1);
+    REQUIRE(identity_equal(difference1, difference2));
+    REQUIRE(identity_equal(node_of<sub>(difference1)->left, node_of<sub>(difference1)->right));
+
+    expression other = sums.make(binary_op<add>(std::string("x"), 2));
+    REQUIRE(sums.size() == 2);
+    REQUIRE(!identity_equal(other, lhs));
+
+    // interned nodes are never changed in place
+    expression copy(difference1);
+    copy.get<binary_op<sub>>().left = 0;
+    REQUIRE(identity_equal(node_of<sub>(difference1)->left, lhs));
+    REQUIRE(node_of<sub>(copy) != node_of<sub>(difference1));
+}
+
+TEST_CASE("hash_cons collects unused nodes", "[hash_cons]")
+{
+    factory_type<add> sums;
+    factory_type<sub> differences;
+    {
+        expression inner = sums.make(binary_op<add>(1, 2));
+        expression outer = sums.make(binary_op<add>(inner, 3));
+        REQUIRE(sums.size() == 2);
+        REQUIRE(sums.collect() == 0);
+    }
+    expression kept = differences.make(binary_op<sub>(5, 4));
+    REQUIRE(sums.collect() == 2);
+    REQUIRE(sums.size() == 0);
+    REQUIRE(differences.collect() == 0);
+    REQUIRE(node_of<sub>(differences.make(binary_op<sub>(5, 4))) == node_of<sub>(kept));
+}
+
+TEST_CASE("hash_cons collects a long chain in one go", "[hash_cons]")
+{
+    int const n = 100000;
+    factory_type<add> factory;
+    {
+        expression chain(0);
+        for (int i = 0; i < n; ++i)
+        {
+            chain = factory.make(binary_op<add>(chain, 1));
+        }
+        REQUIRE(factory.size() == std::size_t(n));
+        REQUIRE(factory.collect() == 0);
+    }
+    REQUIRE(factory.collect() == std::size_t(n));
+    REQUIRE(factory.size() == 0);
+}
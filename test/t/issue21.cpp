@@ -42,3 +42,27 @@ TEST_CASE( "set() works cleanly even if the constructor throws ", "[variant]" )
 
 }
 
+
+struct t3 {
+    t3() = default;
+    t3(t3 const&) { // copy fails
+        throw std::runtime_error("fail");
+    }
+    ~t3() {
+        ++destroyed;
+    }
+    static int destroyed;
+};
+
+int t3::destroyed = 0;
+
+TEST_CASE( "construction doesn't destroy anything if the constructor throws", "[variant]" ) {
+
+    using variant_type = mapbox::util::variant<t1, t3>;
+
+    variant_type v{mapbox::util::in_place_type_t<t3>()};
+    t3::destroyed = 0;
+    REQUIRE_THROWS(variant_type{v});
+    REQUIRE_THROWS(variant_type(mapbox::util::in_place_type_t<t3>(), v.get<t3>()));
+    REQUIRE(t3::destroyed == 0);
+}
@@ -32,3 +32,140 @@ TEST_CASE( "variant visitation", "[visitor][unary visitor]" ) {
     REQUIRE(var.get<int>() == 456);
 }
 
+
+struct counting_visitor
+{
+    counting_visitor() = default;
+    counting_visitor(counting_visitor const& rhs)
+        : count(rhs.count), copies(rhs.copies + 1) {}
+    counting_visitor(counting_visitor && rhs)
+        : count(rhs.count), copies(rhs.copies + 1) {}
+
+    template <typename... Ts>
+    void operator()(Ts const&...)
+    {
+        ++count;
+    }
+
+    int count = 0;
+    int copies = 0;
+};
+
+struct rvalue_visitor
+{
+    template <typename T>
+    int operator()(T const&) &
+    {
+        return 1;
+    }
+
+    template <typename T>
+    int operator()(T const&) &&
+    {
+        return 2;
+    }
+};
+
+TEST_CASE( "stateful visitor is passed by reference", "[visitor]" ) {
+    using variant_type = mapbox::util::variant<int, double, std::string>;
+    variant_type v0(123);
+    variant_type const v1(std::string("foo"));
+    mapbox::util::variant<bool, int> v2(true);
+    counting_visitor visitor;
+
+    SECTION( "unary" ) {
+        mapbox::util::apply_visitor(visitor, v0);
+        mapbox::util::apply_visitor(visitor, v1);
+        REQUIRE(visitor.count == 2);
+    }
+
+    SECTION( "binary" ) {
+        mapbox::util::apply_visitor(visitor, v0, v0);
+        mapbox::util::apply_visitor(visitor, v1, v1);
+        REQUIRE(visitor.count == 2);
+    }
+
+    SECTION( "n-ary" ) {
+        mapbox::util::apply_visitor(visitor, v0, v1, v2);
+        REQUIRE(visitor.count == 1);
+    }
+
+    REQUIRE(visitor.copies == 0);
+}
+
+TEST_CASE( "rvalue visitor is forwarded as an rvalue", "[visitor]" ) {
+    using variant_type = mapbox::util::variant<int, double, std::string>;
+    variant_type v(123);
+    rvalue_visitor visitor;
+    REQUIRE(mapbox::util::apply_visitor(visitor, v) == 1);
+    REQUIRE(mapbox::util::apply_visitor(rvalue_visitor(), v) == 2);
+}
+
+struct moving_visitor
+{
+    template <typename T>
+    std::string operator()(T &&) const
+    {
+        return "copy";
+    }
+
+    std::string operator()(std::string && str) const
+    {
+        return std::move(str);
+    }
+
+    std::string operator()(std::string && lhs, std::string && rhs) const
+    {
+        std::string l(std::move(lhs));
+        std::string r(std::move(rhs));
+        return l + r;
+    }
+
+    template <typename T, typename U>
+    std::string operator()(T &&, U &&) const
+    {
+        return "copy";
+    }
+};
+
+TEST_CASE( "rvalue variant hands out its alternative as an rvalue", "[visitor]" ) {
+    using variant_type = mapbox::util::variant<int, std::string>;
+    std::string const long_string(64, 'x');
+
+    SECTION( "unary" ) {
+        variant_type v(long_string);
+        REQUIRE(mapbox::util::apply_visitor(moving_visitor(), std::move(v)) == long_string);
+        REQUIRE(v.get<std::string>().empty());
+        variant_type const cv(long_string);
+        REQUIRE(mapbox::util::apply_visitor(moving_visitor(), cv) == "copy");
+    }
+
+    SECTION( "binary" ) {
+        variant_type v0(long_string);
+        variant_type v1(long_string);
+        REQUIRE(mapbox::util::apply_visitor(moving_visitor(), std::move(v0), std::move(v1)) == long_string + long_string);
+        REQUIRE(v0.get<std::string>().empty());
+        REQUIRE(v1.get<std::string>().empty());
+        variant_type v2(long_string);
+        REQUIRE(mapbox::util::apply_visitor(moving_visitor(), v2, std::move(v2)) == "copy");
+        REQUIRE(v2.get<std::string>() == long_string);
+    }
+
+    SECTION( "recursive_wrapper" ) {
+        mapbox::util::variant<int, mapbox::util::recursive_wrapper<std::string>> v(long_string);
+        REQUIRE(mapbox::util::apply_visitor(moving_visitor(), std::move(v)) == long_string);
+        REQUIRE(v.get<std::string>().empty());
+    }
+
+    SECTION( "get" ) {
+        variant_type v(long_string);
+        std::string str = std::move(v).get<std::string>();
+        REQUIRE(str == long_string);
+        REQUIRE(v.get<std::string>().empty());
+        v = long_string;
+        str = mapbox::util::get<std::string>(std::move(v));
+        REQUIRE(str == long_string);
+        REQUIRE(v.get<std::string>().empty());
+        REQUIRE_THROWS(std::move(v).get<int>());
+    }
+}
@@ -0,0 +1,131 @@
+#include "catch.hpp"
+
+#include "nan_box.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+namespace {
+
+using mapbox::util::nan_box;
+
+struct describe : mapbox::util::static_visitor<std::string>
+{
+    std::string operator()(nan_box::null_type) const
+    {
+        return "null";
+    }
+
+    std::string operator()(bool value) const
+    {
+        return value ? "true" : "false";
+    }
+
+    std::string operator()(std::int32_t value) const
+    {
+        return "int " + std::to_string(value);
+    }
+
+    std::string operator()(double value) const
+    {
+        return std::isnan(value) ? "nan" : "double " + std::to_string(static_cast<std::int32_t>(value));
+    }
+
+    std::string operator()(std::string const& value) const
+    {
+        return "string " + value;
+    }
+};
+
+struct appender
+{
+    template <typename T>
+    void operator()(T) const {}
+
+    void operator()(std::string & value) const
+    {
+        value += "!";
+    }
+};
+
+} // namespace
+
+TEST_CASE( "nan_box packs every alternative into 8 bytes", "[nan_box]" ) {
+    REQUIRE(sizeof(nan_box) == 8);
+    REQUIRE(mapbox::util::is_trivially_relocatable<nan_box>::value);
+}
+
+TEST_CASE( "nan_box holds each alternative", "[nan_box]" ) {
+
+    SECTION( "null" ) {
+        nan_box v;
+        REQUIRE(v.is<nan_box::null_type>());
+        REQUIRE(v.which() == 0);
+        REQUIRE(mapbox::util::apply_visitor(describe(), v) == "null");
+    }
+
+    SECTION( "bool" ) {
+        nan_box v(true);
+        REQUIRE(v.is<bool>());
+        REQUIRE(v.which() == 1);
+        REQUIRE(v.get<bool>());
+        REQUIRE(!nan_box(false).get<bool>());
+        REQUIRE(mapbox::util::apply_visitor(describe(), v) == "true");
+    }
+
+    SECTION( "int32" ) {
+        nan_box v(std::int32_t(-7));
+        REQUIRE(v.is<std::int32_t>());
+        REQUIRE(v.which() == 2);
+        REQUIRE(v.get<std::int32_t>() == -7);
+        REQUIRE(nan_box(std::numeric_limits<std::int32_t>::min()).get<std::int32_t>() == std::numeric_limits<std::int32_t>::min());
+        REQUIRE(nan_box(std::numeric_limits<std::int32_t>::max()).get<std::int32_t>() == std::numeric_limits<std::int32_t>::max());
+        REQUIRE_THROWS(v.get<double>());
+    }
+
+    SECTION( "double" ) {
+        nan_box v(-2.5);
+        REQUIRE(v.is<double>());
+        REQUIRE(v.which() == 3);
+        REQUIRE(v.get<double>() == Approx(-2.5));
+        REQUIRE(nan_box(-std::numeric_limits<double>::infinity()).get<double>() == -std::numeric_limits<double>::infinity());
+        REQUIRE(nan_box(std::numeric_limits<double>::max()).get<double>() == std::numeric_limits<double>::max());
+    }
+
+    SECTION( "NaNs stay doubles" ) {
+        nan_box v(-std::numeric_limits<double>::quiet_NaN());
+        REQUIRE(v.is<double>());
+        REQUIRE(std::isnan(v.get<double>()));
+        REQUIRE(mapbox::util::apply_visitor(describe(), v) == "nan");
+    }
+
+    SECTION( "string" ) {
+        nan_box v("foo");
+        REQUIRE(v.is<std::string>());
+        REQUIRE(v.which() == 4);
+        REQUIRE(v.get<std::string>() == "foo");
+        mapbox::util::apply_visitor(appender(), v);
+        REQUIRE(mapbox::util::apply_visitor(describe(), v) == "string foo!");
+    }
+}
+
+TEST_CASE( "nan_box copies and moves strings", "[nan_box]" ) {
+    nan_box a(std::string("foo"));
+    nan_box b(a);
+    b.get<std::string>() += "bar";
+    REQUIRE(a.get<std::string>() == "foo");
+    REQUIRE(b.get<std::string>() == "foobar");
+
+    a = b;
+    REQUIRE(a.get<std::string>() == "foobar");
+    a = nan_box(1.5);
+    REQUIRE(a.get<double>() == Approx(1.5));
+    a = b;
+    REQUIRE(a.get<std::string>() == "foobar");
+
+    nan_box c(std::move(b));
+    REQUIRE(c.get<std::string>() == "foobar");
+    REQUIRE(b.is<nan_box::null_type>());
+}
@@ -64,8 +64,9 @@ TEST_CASE( "emplace initialization, reset", "[optional]" ) {
     REQUIRE(!dummy_opt);
 
     // rvalues, baby!
-    dummy_opt.emplace(1, 2);
+    dummy & ref = dummy_opt.emplace(1, 2);
     REQUIRE(dummy_opt);
+    REQUIRE(&ref == &dummy_opt.get());
     REQUIRE(dummy_opt.get().m_1 == 1);
     REQUIRE((*dummy_opt).m_2 == 2);
 
@@ -0,0 +1,120 @@
+#include "catch.hpp"
+#include "expression_tree.hpp"
+
+#include "pointer_variant.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+
+namespace {
+
+struct tree_traits;
+
+using node = expression_tree::binary_op<expression_tree::add, tree_traits>;
+
+struct tree_traits
+{
+    using expression = mapbox::util::pointer_variant<std::int32_t,
+                                                     std::unique_ptr<node>,
+                                                     mapbox::util::recursive_wrapper<std::string>>;
+};
+
+using expression = tree_traits::expression;
+
+struct calculator : mapbox::util::static_visitor<std::int32_t>
+{
+    std::int32_t operator()(std::int32_t value) const
+    {
+        return value;
+    }
+
+    std::int32_t operator()(node const& n) const
+    {
+        return mapbox::util::apply_visitor(*this, n.left) + mapbox::util::apply_visitor(*this, n.right);
+    }
+
+    std::int32_t operator()(std::string const& str) const
+    {
+        return static_cast<std::int32_t>(str.size());
+    }
+};
+
+struct appender
+{
+    template <typename T>
+    void operator()(T) const {}
+
+    void operator()(std::string & str) const
+    {
+        str += "!";
+    }
+};
+
+} // namespace
+
+TEST_CASE( "pointer_variant fits into a single word", "[pointer_variant]" ) {
+    REQUIRE(sizeof(expression) == sizeof(void*));
+    REQUIRE(sizeof(mapbox::util::pointer_variant<std::int32_t, std::int32_t*>) == sizeof(void*));
+    REQUIRE(mapbox::util::is_trivially_relocatable<expression>::value);
+}
+
+TEST_CASE( "pointer_variant holds integers and pointers", "[pointer_variant]" ) {
+
+    SECTION( "default" ) {
+        expression e;
+        REQUIRE(e.is<std::int32_t>());
+        REQUIRE(e.which() == 0);
+        REQUIRE(e.get<std::int32_t>() == 0);
+    }
+
+    SECTION( "integers keep their sign" ) {
+        expression e(std::int32_t(-42));
+        REQUIRE(e.get<std::int32_t>() == -42);
+        e = std::numeric_limits<std::int32_t>::min();
+        REQUIRE(e.get<std::int32_t>() == std::numeric_limits<std::int32_t>::min());
+        e = std::numeric_limits<std::int32_t>::max();
+        REQUIRE(e.get<std::int32_t>() == std::numeric_limits<std::int32_t>::max());
+    }
+
+    SECTION( "raw pointers are not owned" ) {
+        std::int32_t value = 7;
+        mapbox::util::pointer_variant<std::int32_t, std::int32_t*> v(&value);
+        REQUIRE(v.which() == 1);
+        REQUIRE(v.get<std::int32_t*>() == &value);
+        REQUIRE_THROWS(v.get<std::int32_t>());
+    }
+
+    SECTION( "recursive_wrapper is copied deeply" ) {
+        expression e(std::string("foo"));
+        REQUIRE(e.which() == 2);
+        REQUIRE(e.get<mapbox::util::recursive_wrapper<std::string>>() == "foo");
+        mapbox::util::pointer_variant<std::int32_t, mapbox::util::recursive_wrapper<std::string>> a(std::string("bar"));
+        auto b = a;
+        mapbox::util::apply_visitor(appender(), b);
+        REQUIRE(a.get<mapbox::util::recursive_wrapper<std::string>>() == "bar");
+        REQUIRE(b.get<mapbox::util::recursive_wrapper<std::string>>() == "bar!");
+        a = b;
+        REQUIRE(a.get<mapbox::util::recursive_wrapper<std::string>>() == "bar!");
+    }
+
+    SECTION( "move leaves the first alternative behind" ) {
+        expression a(std::string("foo"));
+        expression b(std::move(a));
+        REQUIRE(a.is<std::int32_t>());
+        REQUIRE(a.get<std::int32_t>() == 0);
+        REQUIRE(b.is<mapbox::util::recursive_wrapper<std::string>>());
+    }
+}
+
+TEST_CASE( "pointer_variant supports visitation of expression trees", "[pointer_variant][visitor]" ) {
+    expression e(std::unique_ptr<node>(
+        new node(std::int32_t(-3),
+                 std::unique_ptr<node>(new node(std::int32_t(5), std::string("abcd"))))));
+    REQUIRE(e.which() == 1);
+    REQUIRE(mapbox::util::apply_visitor(calculator(), e) == 6);
+    expression const& ce = e;
+    REQUIRE(mapbox::util::apply_visitor(calculator(), ce) == 6);
+    REQUIRE(ce.get<std::unique_ptr<node>>().left.get<std::int32_t>() == -3);
+}
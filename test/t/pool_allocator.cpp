@@ -0,0 +1,169 @@
+#include "catch.hpp"
+#include "expression_tree.hpp"
+
+#include "pool_allocator.hpp"
+#include "variant.hpp"
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using mapbox::util::pool_allocator;
+using mapbox::util::pooled_recursive_wrapper;
+
+using expression_tree::add;
+using expression_tree::calculator;
+using expression_tree::sub;
+
+struct tree_traits;
+
+template <typename Op>
+using binary_op = expression_tree::binary_op<Op, tree_traits>;
+
+struct tree_traits
+{
+    using expression = mapbox::util::variant<int,
+                                             pooled_recursive_wrapper<binary_op<add>>,
+                                             pooled_recursive_wrapper<binary_op<sub>>>;
+};
+
+using expression = tree_traits::expression;
+
+struct big
+{
+    char bytes[1000];
+};
+
+using thread_exit_pool = mapbox::util::detail::node_pool<48>;
+
+// frees its block when the thread exits, after the free list of the pool
+// if it was constructed first
+struct freed_at_thread_exit
+{
+    void* block = nullptr;
+    std::size_t* local_free = nullptr;
+
+    ~freed_at_thread_exit()
+    {
+        thread_exit_pool::deallocate(block);
+        thread_exit_pool::deallocate(thread_exit_pool::allocate());
+        *local_free = thread_exit_pool::local_free();
+    }
+};
+
+} // namespace
+
+TEST_CASE("pool_allocator reuses freed blocks", "[pool_allocator]")
+{
+    pool_allocator<std::int64_t> alloc;
+    std::int64_t* a = alloc.allocate(1);
+    std::int64_t* b = alloc.allocate(1);
+    REQUIRE(a != b);
+    alloc.deallocate(a, 1);
+    REQUIRE(alloc.allocate(1) == a);
+
+    // same size class, same free list
+    pool_allocator<std::int32_t> other(alloc);
+    alloc.deallocate(b, 1);
+    REQUIRE(static_cast<void*>(other.allocate(1)) == static_cast<void*>(b));
+    REQUIRE(other == alloc);
+
+    // arrays and large objects bypass the pools
+    std::int64_t* array = alloc.allocate(10);
+    alloc.deallocate(array, 10);
+    pool_allocator<big> big_alloc;
+    big_alloc.deallocate(big_alloc.allocate(1), 1);
+    alloc.deallocate(a, 1);
+}
+
+TEST_CASE("a free list hands blocks back past its high water mark", "[pool_allocator]")
+{
+    using pool = mapbox::util::detail::node_pool<64>;
+    std::size_t const high_water = mapbox::util::detail::pool_high_water / 64;
+
+    // e.g. the blocks of a tree built on another thread and freed here
+    std::vector<void*> blocks;
+    for (std::size_t i = 0; i < 3 * high_water; ++i)
+    {
+        blocks.push_back(pool::allocate());
+    }
+    for (void* block : blocks)
+    {
+        pool::deallocate(block);
+    }
+    REQUIRE(pool::local_free() < high_water);
+
+    // handed back blocks are reused before new chunks are cut
+    std::set<void*> const known(blocks.begin(), blocks.end());
+    blocks.clear();
+    for (std::size_t i = 0; i < 3 * high_water; ++i)
+    {
+        blocks.push_back(pool::allocate());
+    }
+    std::size_t reused = 0;
+    for (void* block : blocks)
+    {
+        if (known.count(block) != 0) ++reused;
+        pool::deallocate(block);
+    }
+    REQUIRE(reused == blocks.size());
+    REQUIRE(pool::local_free() < high_water);
+}
+
+TEST_CASE("blocks freed after the free list of a thread is gone", "[pool_allocator]")
+{
+    std::size_t local_free = 1;
+    std::thread thread([&local_free] {
+        static thread_local freed_at_thread_exit holder;
+        holder.local_free = &local_free;
+        holder.block = thread_exit_pool::allocate();
+    });
+    thread.join();
+    // handed to the shared pool instead of the destroyed list
+    REQUIRE(local_free == 0);
+}
+
+TEST_CASE("pooled_recursive_wrapper", "[pool_allocator]")
+{
+    REQUIRE(sizeof(pooled_recursive_wrapper<big>) == sizeof(big*));
+    REQUIRE(mapbox::util::is_trivially_relocatable<pooled_recursive_wrapper<big>>::value);
+
+    pooled_recursive_wrapper<std::string> a(std::string("pooled"));
+    pooled_recursive_wrapper<std::string> b(a);
+    REQUIRE(b.get() == "pooled");
+    REQUIRE(b.get_pointer() != a.get_pointer());
+    pooled_recursive_wrapper<std::string> c(std::move(a));
+    REQUIRE(c.get() == "pooled");
+    b = std::string("other");
+    c = std::move(b);
+    REQUIRE(c.get() == "other");
+}
+
+TEST_CASE("recursive variant with pooled nodes", "[pool_allocator]")
+{
+    // (1 + 2) - (10 - 4) + ... built 100 times over
+    std::vector<expression> trees;
+    for (int i = 0; i < 100; ++i)
+    {
+        expression result(binary_op<sub>(binary_op<add>(1, 2), binary_op<sub>(10, 4)));
+        for (int j = 0; j < 50; ++j)
+        {
+            result = binary_op<add>(std::move(result), j);
+        }
+        trees.push_back(std::move(result));
+    }
+    for (auto const& tree : trees)
+    {
+        REQUIRE(mapbox::util::apply_visitor(calculator(), tree) == -3 + 49 * 50 / 2);
+    }
+
+    expression copy(trees.front());
+    REQUIRE(copy.is<binary_op<add>>());
+    REQUIRE(copy.get<binary_op<add>>().right.get<int>() == 49);
+    REQUIRE(mapbox::util::apply_visitor(calculator(), copy) == -3 + 49 * 50 / 2);
+}
@@ -0,0 +1,192 @@
+#include "catch.hpp"
+#include "expression_tree.hpp"
+
+#include "postfix_program.hpp"
+#include "recursive_traits.hpp"
+#include "variant.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using expression_tree::add;
+using expression_tree::sub;
+
+struct property
+{
+    std::string key;
+};
+
+struct tree_traits;
+
+template <typename Op>
+using binary_op = expression_tree::binary_op<Op, tree_traits>;
+
+struct tree_traits
+{
+    using expression = mapbox::util::variant<int,
+                                             property,
+                                             mapbox::util::recursive_wrapper<binary_op<add>>,
+                                             mapbox::util::recursive_wrapper<binary_op<sub>>>;
+};
+
+using expression = tree_traits::expression;
+
+enum class opcode : std::uint8_t
+{
+    add,
+    sub,
+    get // the property whose key id is the operand
+};
+
+using feature = std::map<std::string, int>;
+
+using program_type = mapbox::util::postfix_program<int, opcode>;
+
+// property keys are turned into ids at compile time
+struct rules
+{
+    std::vector<std::string> & keys;
+
+    void operator()(int v, program_type & program) const
+    {
+        program.push(v);
+    }
+
+    void operator()(property const& p, program_type & program) const
+    {
+        keys.push_back(p.key);
+        program.push(static_cast<int>(keys.size() - 1));
+        program.apply(opcode::get, 1);
+    }
+
+    void operator()(binary_op<add> const&, program_type & program) const
+    {
+        program.apply(opcode::add, 2);
+    }
+
+    void operator()(binary_op<sub> const&, program_type & program) const
+    {
+        program.apply(opcode::sub, 2);
+    }
+};
+
+struct machine
+{
+    std::vector<std::string> const& keys;
+    feature const& f;
+
+    int operator()(opcode op, int const* args, std::size_t) const
+    {
+        switch (op)
+        {
+        case opcode::add:
+            return args[0] + args[1];
+        case opcode::sub:
+            return args[0] - args[1];
+        case opcode::get:
+        default:
+            return f.at(keys[static_cast<std::size_t>(args[0])]);
+        }
+    }
+};
+
+// the recursive evaluation the program replaces
+struct calculator : mapbox::util::static_visitor<int>
+{
+    feature const& f;
+
+    explicit calculator(feature const& f_)
+        : f(f_) {}
+
+    int operator()(int v) const
+    {
+        return v;
+    }
+
+    int operator()(property const& p) const
+    {
+        return f.at(p.key);
+    }
+
+    int operator()(binary_op<add> const& op) const
+    {
+        return mapbox::util::apply_visitor(*this, op.left) + mapbox::util::apply_visitor(*this, op.right);
+    }
+
+    int operator()(binary_op<sub> const& op) const
+    {
+        return mapbox::util::apply_visitor(*this, op.left) - mapbox::util::apply_visitor(*this, op.right);
+    }
+};
+
+} // namespace
+
+TEST_CASE("postfix_program evaluates pushed constants and opcodes", "[postfix_program]")
+{
+    auto eval = [](opcode op, int const* args, std::size_t) {
+        return op == opcode::add ? args[0] + args[1] : args[0] - args[1];
+    };
+
+    // 10 - (1 + 2)
+    program_type program;
+    program.push(10);
+    program.push(1);
+    program.push(2);
+    program.apply(opcode::add, 2);
+    program.apply(opcode::sub, 2);
+    REQUIRE(program.code().size() == 5);
+    REQUIRE(program.max_depth() == 3);
+    REQUIRE(program.evaluate(eval) == 7);
+
+    std::vector<int> stack;
+    REQUIRE(program.evaluate(eval, stack) == 7);
+    REQUIRE(program.evaluate(eval, stack) == 7);
+
+    program_type invalid;
+    REQUIRE_THROWS(invalid.evaluate(eval));
+    invalid.push(1);
+    REQUIRE_THROWS(invalid.apply(opcode::add, 2));
+    invalid.push(2);
+    REQUIRE_THROWS(invalid.evaluate(eval));
+}
+
+TEST_CASE("compile_postfix", "[postfix_program]")
+{
+    // (height - 2) + (1 + min_zoom)
+    expression tree(binary_op<add>(binary_op<sub>(property{"height"}, 2),
+                                   binary_op<add>(1, property{"min_zoom"})));
+    std::vector<std::string> keys;
+    program_type program = mapbox::util::compile_postfix<int, opcode>(tree, rules{keys});
+    REQUIRE(program.code().size() == 9);
+    REQUIRE(program.max_depth() == 3);
+
+    feature f1{{"height", 10}, {"min_zoom", 4}};
+    feature f2{{"height", 3}, {"min_zoom", 12}};
+    for (feature const& f : {f1, f2})
+    {
+        int expected = mapbox::util::apply_visitor(calculator(f), tree);
+        REQUIRE(program.evaluate(machine{keys, f}) == expected);
+    }
+}
+
+TEST_CASE("compile_postfix of a deep chain", "[postfix_program]")
+{
+    expression tree(0);
+    for (int i = 0; i < 100000; ++i)
+    {
+        tree = binary_op<add>(std::move(tree), 1);
+    }
+    std::vector<std::string> keys;
+    program_type program = mapbox::util::compile_postfix<int, opcode>(tree, rules{keys});
+    REQUIRE(program.code().size() == 200001);
+    REQUIRE(program.max_depth() == 2);
+    feature f;
+    REQUIRE(program.evaluate(machine{keys, f}) == 100000);
+    mapbox::util::iterative_destroy(tree);
+}
@@ -0,0 +1,176 @@
+#include "catch.hpp"
+#include "expression_tree.hpp"
+
+#include "recursive_traits.hpp"
+#include "shared_recursive_wrapper.hpp"
+#include "variant.hpp"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using expression_tree::add;
+using expression_tree::sub;
+
+struct tree_traits;
+
+template <typename Op>
+using binary_op = expression_tree::binary_op<Op, tree_traits>;
+
+struct tree_traits
+{
+    using expression = mapbox::util::variant<int,
+                                             mapbox::util::recursive_wrapper<binary_op<add>>,
+                                             mapbox::util::recursive_wrapper<binary_op<sub>>>;
+};
+
+using expression = tree_traits::expression;
+
+struct shared_tree_traits;
+
+template <typename Op>
+using shared_op = expression_tree::binary_op<Op, shared_tree_traits>;
+
+struct shared_tree_traits
+{
+    using expression = mapbox::util::variant<int, mapbox::util::shared_recursive_wrapper<shared_op<add>>>;
+};
+
+using shared_expression = shared_tree_traits::expression;
+
+struct unique_op;
+
+using unique_expression = mapbox::util::variant<int, std::unique_ptr<unique_op>>;
+
+struct unique_op
+{
+    std::vector<unique_expression> operands;
+};
+
+// number of nodes and sum of leaves, walked with an explicit stack
+template <typename V>
+std::pair<std::size_t, long> summarize(V const& tree)
+{
+    std::pair<std::size_t, long> result(0, 0);
+    std::vector<V const*> pending{&tree};
+    while (!pending.empty())
+    {
+        V const* current = pending.back();
+        pending.pop_back();
+        ++result.first;
+        if (current->template is<int>()) result.second += current->template get<int>();
+        mapbox::util::for_each_child(*current, [&pending](V const& child) {
+            pending.push_back(&child);
+        });
+    }
+    return result;
+}
+
+// 1 + 2 + ... + n as a left leaning chain
+expression make_chain(int n)
+{
+    expression tree(binary_op<sub>(0, 0));
+    for (int i = 1; i <= n; ++i)
+    {
+        tree = binary_op<add>(std::move(tree), i);
+    }
+    return tree;
+}
+
+} // namespace
+
+namespace mapbox { namespace util {
+
+template <>
+struct recursive_children<unique_op>
+{
+    template <typename Node, typename F>
+    static void for_each(Node & node, F && f)
+    {
+        for (auto & operand : node.operands) f(operand);
+    }
+
+    static unique_op copy_node(unique_op const& node)
+    {
+        unique_op copy;
+        copy.operands.resize(node.operands.size());
+        return copy;
+    }
+};
+
+}}
+
+TEST_CASE("for_each_child", "[recursive_traits]")
+{
+    expression tree(binary_op<add>(1, binary_op<sub>(5, 3)));
+    std::vector<expression*> children;
+    mapbox::util::for_each_child(tree, [&children](expression & child) {
+        children.push_back(&child);
+    });
+    REQUIRE(children.size() == 2);
+    REQUIRE(children[0]->get<int>() == 1);
+    REQUIRE(children[1]->is<binary_op<sub>>());
+
+    expression leaf(7);
+    std::size_t count = 0;
+    mapbox::util::for_each_child(leaf, [&count](expression &) { ++count; });
+    REQUIRE(count == 0);
+
+    REQUIRE(summarize(tree) == std::make_pair(std::size_t(5), 9L));
+}
+
+TEST_CASE("iterative destroy and copy of a deep chain", "[recursive_traits]")
+{
+    int const n = 100000;
+    expression tree = make_chain(n);
+    REQUIRE(summarize(tree) == std::make_pair(std::size_t(2 * n + 3), long(n) * (n + 1) / 2));
+
+    expression const& source = tree;
+    expression copy = mapbox::util::iterative_copy(source);
+    REQUIRE(summarize(copy) == summarize(tree));
+    REQUIRE(&copy.get<binary_op<add>>() != &tree.get<binary_op<add>>());
+
+    copy.get<binary_op<add>>().right = 0;
+    REQUIRE(summarize(copy).second == summarize(tree).second - n);
+
+    mapbox::util::iterative_destroy(copy);
+    mapbox::util::iterative_destroy(tree);
+}
+
+TEST_CASE("iterative destroy of shared and unique_ptr trees", "[recursive_traits]")
+{
+    shared_expression shared(shared_op<add>(1, 2));
+    for (int i = 0; i < 100000; ++i)
+    {
+        shared = shared_op<add>(std::move(shared), 1);
+    }
+    shared_expression other(shared);
+    mapbox::util::iterative_destroy(shared);
+    // nodes still used by another tree are left alone
+    REQUIRE(summarize(other).second == 100003);
+    // shared nodes are shared by a copy
+    shared_expression const& shared_source = other;
+    shared_expression shared_copy = mapbox::util::iterative_copy(shared_source);
+    REQUIRE(&static_cast<shared_expression const&>(shared_copy).get<shared_op<add>>() == &shared_source.get<shared_op<add>>());
+    mapbox::util::iterative_destroy(shared_copy);
+    mapbox::util::iterative_destroy(other);
+
+    unique_expression chain(1);
+    for (int i = 0; i < 100000; ++i)
+    {
+        std::unique_ptr<unique_op> op(new unique_op);
+        op->operands.push_back(std::move(chain));
+        op->operands.push_back(unique_expression(1));
+        chain = std::move(op);
+    }
+    REQUIRE(summarize(chain).second == 100001);
+
+    unique_expression const& source = chain;
+    unique_expression copy = mapbox::util::iterative_copy(source);
+    REQUIRE(summarize(copy) == summarize(chain));
+    REQUIRE(copy.get<std::unique_ptr<unique_op>>().get() != chain.get<std::unique_ptr<unique_op>>().get());
+    mapbox::util::iterative_destroy(copy);
+    mapbox::util::iterative_destroy(chain);
+}
@@ -2,6 +2,7 @@
 #include "catch.hpp"
 
 #include "recursive_wrapper.hpp"
+#include "variant.hpp"
 
 #include <utility>
 
@@ -67,6 +68,11 @@ TEST_CASE("move of recursive wrapper") {
         rwi b{std::move(a)};
         REQUIRE(b.get() == 1);
         REQUIRE(a.get_pointer() == nullptr);
+
+        a = 3;
+        REQUIRE(a.get() == 3);
+        a = b.get();
+        REQUIRE(a.get() == 1);
     }
 
     SECTION("swap with operand in operator=") {
@@ -78,6 +84,93 @@ TEST_CASE("move of recursive wrapper") {
 
 }
 
+struct link;
+
+using chain = mapbox::util::variant<int, mapbox::util::recursive_wrapper<link>>;
+
+struct link
+{
+    chain next;
+    int value;
+
+    link(chain && next_, int value_)
+        : next(std::move(next_)), value(value_) {}
+};
+
+TEST_CASE("rebuilding a tree around itself") {
+    // the old root is moved out of the wrapper that then receives the new
+    // root by same-type assignment
+    chain c(link(0, 0));
+    for (int i = 1; i <= 100; ++i)
+    {
+        c = link(std::move(c), i);
+    }
+    int sum = 0;
+    chain const* current = &c;
+    while (current->is<link>())
+    {
+        sum += current->get<link>().value;
+        current = &current->get<link>().next;
+    }
+    REQUIRE(sum == 5050);
+}
+
+int sum_of(chain const& c)
+{
+    int sum = 0;
+    chain const* current = &c;
+    while (current->is<link>())
+    {
+        sum += current->get<link>().value;
+        current = &current->get<link>().next;
+    }
+    return sum;
+}
+
+TEST_CASE("assigning a subtree to its own root") {
+    // 3 -> 2 -> 1 -> 0
+    chain c(link(link(link(0, 1), 2), 3));
+
+    SECTION("copy") {
+        chain & child = c.get<link>().next;
+        c = child;
+        REQUIRE(sum_of(c) == 3);
+        chain & leaf = c.get<link>().next.get<link>().next;
+        c = leaf;
+        REQUIRE(c.get<int>() == 0);
+    }
+
+    SECTION("move") {
+        c = std::move(c.get<link>().next);
+        REQUIRE(sum_of(c) == 3);
+        c = std::move(c.get<link>().next.get<link>().next);
+        REQUIRE(c.get<int>() == 0);
+    }
+}
+
+template <typename Tag>
+struct tagged_link;
+
+template <typename Tag>
+struct tagged_chain
+{
+    using type = mapbox::util::variant<int, mapbox::util::recursive_wrapper<tagged_link<Tag>>>;
+};
+
+template <typename Tag>
+struct tagged_link
+{
+    typename tagged_chain<Tag>::type next;
+};
+
+TEST_CASE("variant of a wrapped class template instantiated first") {
+    // the variant is instantiated before tagged_link<void>, whose definition
+    // needs the variant to be complete
+    tagged_chain<void>::type c(tagged_link<void>{1});
+    REQUIRE(c.is<tagged_link<void>>());
+    REQUIRE(c.get<tagged_link<void>>().next.get<int>() == 1);
+}
+
 TEST_CASE("recursive wrapper of pair<int, int>") {
 
     SECTION("default constructed") {
@@ -0,0 +1,128 @@
+#include "catch.hpp"
+#include "expression_tree.hpp"
+
+#include "shared_recursive_wrapper.hpp"
+#include "variant.hpp"
+
+#include <string>
+#include <utility>
+
+namespace {
+
+using mapbox::util::shared_recursive_wrapper;
+using mapbox::util::local_shared_recursive_wrapper;
+
+using expression_tree::add;
+using expression_tree::calculator;
+using expression_tree::sub;
+
+struct tree_traits;
+
+template <typename Op>
+using binary_op = expression_tree::binary_op<Op, tree_traits>;
+
+struct tree_traits
+{
+    using expression = mapbox::util::variant<int,
+                                             shared_recursive_wrapper<binary_op<add>>,
+                                             shared_recursive_wrapper<binary_op<sub>>>;
+};
+
+using expression = tree_traits::expression;
+
+// doubles every leaf through mutable access with get<T>()
+void double_leaves(expression & tree)
+{
+    if (tree.is<int>())
+    {
+        tree.get<int>() *= 2;
+    }
+    else if (tree.is<binary_op<add>>())
+    {
+        binary_op<add> & binary = tree.get<binary_op<add>>();
+        double_leaves(binary.left);
+        double_leaves(binary.right);
+    }
+    else
+    {
+        binary_op<sub> & binary = tree.get<binary_op<sub>>();
+        double_leaves(binary.left);
+        double_leaves(binary.right);
+    }
+}
+
+} // namespace
+
+TEST_CASE("shared_recursive_wrapper copies share the node", "[shared_recursive_wrapper]")
+{
+    using wrapper = shared_recursive_wrapper<std::string>;
+
+    wrapper a(std::string("style"));
+    REQUIRE(a.unique());
+    wrapper b(a);
+    REQUIRE(a.use_count() == 2);
+    REQUIRE(static_cast<wrapper const&>(b).get_pointer() == static_cast<wrapper const&>(a).get_pointer());
+
+    // const access doesn't copy
+    wrapper const& c = b;
+    REQUIRE(c.get() == "style");
+    REQUIRE(a.use_count() == 2);
+
+    // mutable access clones
+    b.get() += " sheet";
+    REQUIRE(b.get() == "style sheet");
+    REQUIRE(a.get() == "style");
+    REQUIRE(a.unique());
+    REQUIRE(b.unique());
+
+    // a unique node is changed in place
+    std::string const* node = static_cast<wrapper const&>(a).get_pointer();
+    a.get() += "s";
+    REQUIRE(static_cast<wrapper const&>(a).get_pointer() == node);
+
+    wrapper d(std::move(a));
+    REQUIRE(a.use_count() == 0);
+    a = std::string("again");
+    REQUIRE(a.get() == "again");
+    d = a;
+    REQUIRE(d.use_count() == 2);
+    d = std::string("other");
+    REQUIRE(a.get() == "again");
+    REQUIRE(d.get() == "other");
+}
+
+TEST_CASE("local_shared_recursive_wrapper", "[shared_recursive_wrapper]")
+{
+    local_shared_recursive_wrapper<int> a(1);
+    local_shared_recursive_wrapper<int> b(a);
+    REQUIRE(b.use_count() == 2);
+    b.get() = 2;
+    REQUIRE(a.get() == 1);
+    REQUIRE(b.get() == 2);
+}
+
+TEST_CASE("recursive variant with shared nodes", "[shared_recursive_wrapper]")
+{
+    expression tree(binary_op<sub>(binary_op<add>(1, 2), binary_op<sub>(10, 4)));
+    for (int i = 0; i < 100; ++i)
+    {
+        tree = binary_op<add>(std::move(tree), 1);
+    }
+    REQUIRE(mapbox::util::apply_visitor(calculator(), tree) == 97);
+
+    expression copy(tree);
+    expression const& const_copy = copy;
+    REQUIRE(&const_copy.get<binary_op<add>>() == &static_cast<expression const&>(tree).get<binary_op<add>>());
+    REQUIRE(mapbox::util::apply_visitor(calculator(), const_copy) == 97);
+
+    // visiting a non-const tree doesn't clone
+    REQUIRE(mapbox::util::apply_visitor(calculator(), copy) == 97);
+    REQUIRE(copy.get<shared_recursive_wrapper<binary_op<add>>>().use_count() == 2);
+
+    // changing the copy leaves the original alone
+    double_leaves(copy);
+    REQUIRE(mapbox::util::apply_visitor(calculator(), copy) == 194);
+    REQUIRE(mapbox::util::apply_visitor(calculator(), tree) == 97);
+    REQUIRE(copy.is<binary_op<add>>());
+    REQUIRE(copy.get<binary_op<add>>().right.get<int>() == 2);
+}
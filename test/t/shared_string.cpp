@@ -0,0 +1,108 @@
+#include "catch.hpp"
+
+#include "shared_string.hpp"
+#include "variant.hpp"
+#include "variant_io.hpp"
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using mapbox::util::shared_string;
+using mapbox::util::local_shared_string;
+
+TEST_CASE("shared_string basics", "[shared_string]")
+{
+    shared_string empty;
+    REQUIRE(empty.empty());
+    REQUIRE(empty.size() == 0);
+    REQUIRE(empty.use_count() == 0);
+    REQUIRE(std::string(empty.c_str()) == "");
+    REQUIRE(shared_string("").empty());
+
+    shared_string s("residential");
+    REQUIRE(s.size() == 11);
+    REQUIRE(s.str() == "residential");
+    REQUIRE(std::string(s.c_str()) == "residential");
+    REQUIRE(s.use_count() == 1);
+
+    shared_string embedded_zero("a\0b", 3);
+    REQUIRE(embedded_zero.str() == std::string("a\0b", 3));
+}
+
+TEST_CASE("shared_string copies share the chars", "[shared_string]")
+{
+    shared_string a(std::string(100, 'x'));
+    {
+        std::vector<shared_string> copies(1000, a);
+        REQUIRE(a.use_count() == 1001);
+        REQUIRE(copies.back().shares(a));
+        REQUIRE(copies.back().data() == a.data());
+    }
+    REQUIRE(a.use_count() == 1);
+
+    shared_string b(std::move(a));
+    REQUIRE(a.empty());
+    REQUIRE(b.use_count() == 1);
+
+    shared_string c("other");
+    c = b;
+    REQUIRE(c.shares(b));
+    REQUIRE(b.use_count() == 2);
+    c = c;
+    REQUIRE(b.use_count() == 2);
+    c = shared_string("again");
+    REQUIRE(b.use_count() == 1);
+    REQUIRE(c == "again");
+    c = std::move(b);
+    REQUIRE(b.empty());
+    REQUIRE(c.use_count() == 1);
+}
+
+TEST_CASE("local_shared_string uses a plain count", "[shared_string]")
+{
+    local_shared_string a("tag");
+    local_shared_string b(a);
+    REQUIRE(a.use_count() == 2);
+    REQUIRE(b == a);
+    b = local_shared_string();
+    REQUIRE(a.use_count() == 1);
+}
+
+TEST_CASE("shared_string comparisons", "[shared_string]")
+{
+    shared_string a("apple");
+    shared_string b("banana");
+
+    REQUIRE(a == shared_string("apple"));
+    REQUIRE(!a.shares(shared_string("apple")));
+    REQUIRE(a != b);
+    REQUIRE(a < b);
+    REQUIRE(b > a);
+    REQUIRE(a <= a);
+    REQUIRE(a >= a);
+    REQUIRE(shared_string() < a);
+    REQUIRE(a == "apple");
+    REQUIRE(a == std::string("apple"));
+}
+
+TEST_CASE("shared_string as a variant alternative", "[shared_string]")
+{
+    using variant_type = mapbox::util::variant<std::int64_t, shared_string>;
+
+    variant_type v1(shared_string("motorway"));
+    variant_type v2(v1);
+    REQUIRE(v2.get<shared_string>().shares(v1.get<shared_string>()));
+    REQUIRE(v1.get<shared_string>().use_count() == 2);
+    REQUIRE(v1 == v2);
+    REQUIRE(v1 < variant_type(shared_string("primary")));
+
+    v2 = std::int64_t(3);
+    REQUIRE(v1.get<shared_string>().use_count() == 1);
+
+    std::ostringstream out;
+    out << v1 << ' ' << v2;
+    REQUIRE(out.str() == "motorway 3");
+}
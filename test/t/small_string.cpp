@@ -0,0 +1,123 @@
+#include "catch.hpp"
+
+#include "small_string.hpp"
+#include "variant.hpp"
+#include "variant_io.hpp"
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <utility>
+
+using mapbox::util::small_string;
+
+TEST_CASE("small_string keeps short strings inline", "[small_string]")
+{
+    small_string empty;
+    REQUIRE(empty.is_inline());
+    REQUIRE(empty.empty());
+    REQUIRE(empty.size() == 0);
+    REQUIRE(std::string(empty.c_str()) == "");
+
+    small_string tag("highway");
+    REQUIRE(tag.is_inline());
+    REQUIRE(tag.size() == 7);
+    REQUIRE(tag.str() == "highway");
+    REQUIRE(std::string(tag.c_str()) == "highway");
+
+    // exactly at capacity, the size byte doubles as the terminator
+    std::string const full(small_string::capacity, 'x');
+    small_string at_capacity(full);
+    REQUIRE(at_capacity.is_inline());
+    REQUIRE(at_capacity.size() == small_string::capacity);
+    REQUIRE(std::string(at_capacity.c_str()) == full);
+}
+
+TEST_CASE("small_string spills long strings to the heap", "[small_string]")
+{
+    std::string const long_str(small_string::capacity + 1, 'y');
+    small_string s(long_str);
+    REQUIRE(!s.is_inline());
+    REQUIRE(s.size() == long_str.size());
+    REQUIRE(s.str() == long_str);
+    REQUIRE(std::string(s.c_str()) == long_str);
+
+    small_string embedded_zero("a\0b", 3);
+    REQUIRE(embedded_zero.size() == 3);
+    REQUIRE(embedded_zero.str() == std::string("a\0b", 3));
+}
+
+TEST_CASE("small_string has a fixed size", "[small_string]")
+{
+    REQUIRE(sizeof(small_string) == 24);
+    REQUIRE(sizeof(mapbox::util::basic_small_string<31>) == 32);
+    REQUIRE(mapbox::util::is_trivially_relocatable<small_string>::value);
+}
+
+TEST_CASE("small_string copy and move", "[small_string]")
+{
+    std::string const long_str(40, 'z');
+    for (auto const& value : {std::string("short"), long_str})
+    {
+        small_string a(value);
+        small_string b(a);
+        REQUIRE(b == a);
+        REQUIRE(b.str() == value);
+        REQUIRE((a.is_inline() || a.data() != b.data()));
+
+        small_string c(std::move(b));
+        REQUIRE(c.str() == value);
+        REQUIRE(b.empty());
+
+        small_string d("other");
+        d = c;
+        REQUIRE(d.str() == value);
+        d = small_string(long_str);
+        REQUIRE(d.str() == long_str);
+        d = std::move(c);
+        REQUIRE(d.str() == value);
+        REQUIRE(c.empty());
+    }
+}
+
+TEST_CASE("small_string comparisons", "[small_string]")
+{
+    small_string a("apple");
+    small_string b("banana");
+    small_string long_a(std::string(30, 'a'));
+
+    REQUIRE(a == small_string("apple"));
+    REQUIRE(a != b);
+    REQUIRE(a < b);
+    REQUIRE(b > a);
+    REQUIRE(a <= a);
+    REQUIRE(a >= a);
+    REQUIRE(small_string("app") < a);
+    REQUIRE(long_a < a);
+    REQUIRE(a == "apple");
+    REQUIRE(a == std::string("apple"));
+    REQUIRE(!(long_a == "apple"));
+}
+
+TEST_CASE("small_string as a variant alternative", "[small_string]")
+{
+    using variant_type = mapbox::util::variant<std::int64_t, small_string>;
+
+    variant_type v1(small_string("motorway"));
+    variant_type v2(small_string("primary"));
+    variant_type v3(std::int64_t(7));
+
+    REQUIRE(v1.is<small_string>());
+    REQUIRE(v1.get<small_string>() == "motorway");
+    REQUIRE(v1 == variant_type(small_string("motorway")));
+    REQUIRE(!(v1 == v2));
+    REQUIRE(v1 < v2);
+    REQUIRE(v1 < v3); // ordered by get_type_index() first
+
+    variant_type copy(v1);
+    REQUIRE(copy == v1);
+
+    std::ostringstream out;
+    out << v1 << ' ' << v3 << ' ' << small_string(std::string(30, 'q'));
+    REQUIRE(out.str() == "motorway 7 " + std::string(30, 'q'));
+}
@@ -0,0 +1,261 @@
+#include "catch.hpp"
+#include "expression_tree.hpp"
+
+#include "recursive_traits.hpp"
+#include "shared_recursive_wrapper.hpp"
+#include "tree_traversal.hpp"
+#include "variant.hpp"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using expression_tree::add;
+using expression_tree::sub;
+
+struct tree_traits;
+
+template <typename Op>
+using binary_op = expression_tree::binary_op<Op, tree_traits>;
+
+struct tree_traits
+{
+    using expression = mapbox::util::variant<int,
+                                             mapbox::util::recursive_wrapper<binary_op<add>>,
+                                             mapbox::util::recursive_wrapper<binary_op<sub>>>;
+};
+
+using expression = tree_traits::expression;
+
+struct shared_tree_traits;
+
+template <typename Op>
+using shared_op = expression_tree::binary_op<Op, shared_tree_traits>;
+
+struct shared_tree_traits
+{
+    using expression = mapbox::util::variant<int,
+                                             mapbox::util::shared_recursive_wrapper<shared_op<add>>,
+                                             mapbox::util::shared_recursive_wrapper<shared_op<sub>>>;
+};
+
+using shared_expression = shared_tree_traits::expression;
+
+struct unique_op;
+
+using unique_expression = mapbox::util::variant<int, std::unique_ptr<unique_op>>;
+
+struct unique_op
+{
+    std::vector<unique_expression> operands;
+};
+
+// one char per node: the leaf value, or the operator
+struct symbol
+{
+    char operator()(int value) const
+    {
+        return static_cast<char>('0' + value);
+    }
+
+    char operator()(binary_op<add> const&) const
+    {
+        return '+';
+    }
+
+    char operator()(binary_op<sub> const&) const
+    {
+        return '-';
+    }
+};
+
+template <typename Cursor>
+std::string walk(Cursor cursor)
+{
+    std::string result;
+    while (expression const* node = cursor.next())
+    {
+        result += mapbox::util::apply_visitor(symbol(), *node);
+    }
+    return result;
+}
+
+// evaluates a tree with a value stack fed in post-order
+struct stack_calculator
+{
+    std::vector<int> & stack;
+
+    void operator()(int value) const
+    {
+        stack.push_back(value);
+    }
+
+    void operator()(binary_op<add> const&) const
+    {
+        int const rhs = pop();
+        stack.back() += rhs;
+    }
+
+    void operator()(binary_op<sub> const&) const
+    {
+        int const rhs = pop();
+        stack.back() -= rhs;
+    }
+
+    int pop() const
+    {
+        int const value = stack.back();
+        stack.pop_back();
+        return value;
+    }
+};
+
+} // namespace
+
+namespace mapbox { namespace util {
+
+template <>
+struct recursive_children<unique_op>
+{
+    template <typename Node, typename F>
+    static void for_each(Node & node, F && f)
+    {
+        for (auto & operand : node.operands) f(operand);
+    }
+};
+
+}}
+
+TEST_CASE("pre-order and post-order", "[tree_traversal]")
+{
+    // (1 + 2) - (3 + 4)
+    expression const tree(binary_op<sub>(binary_op<add>(1, 2), binary_op<add>(3, 4)));
+
+    REQUIRE(walk(mapbox::util::preorder_cursor<expression const>(tree)) == "-+12+34");
+    REQUIRE(walk(mapbox::util::postorder_cursor<expression const>(tree)) == "12+34+-");
+    REQUIRE(walk(mapbox::util::preorder_cursor<expression const, false>(tree)) == "-+12+34");
+    REQUIRE(walk(mapbox::util::postorder_cursor<expression const, false>(tree)) == "12+34+-");
+
+    expression const leaf(7);
+    REQUIRE(walk(mapbox::util::preorder_cursor<expression const>(leaf)) == "7");
+    REQUIRE(walk(mapbox::util::postorder_cursor<expression const>(leaf)) == "7");
+
+    std::vector<int> stack;
+    mapbox::util::for_each_postorder(tree, [&stack](expression const& node) {
+        mapbox::util::apply_visitor(stack_calculator{stack}, node);
+    });
+    REQUIRE(stack == std::vector<int>{-4});
+
+    std::size_t count = 0;
+    mapbox::util::for_each_preorder(tree, [&count](expression const&) { ++count; });
+    REQUIRE(count == 7);
+
+    int const sum = mapbox::util::fold_tree(tree, 0, [](int acc, expression const& node) {
+        return node.is<int>() ? acc + node.get<int>() : acc;
+    });
+    REQUIRE(sum == 10);
+}
+
+TEST_CASE("cursors can be paused and changed on the way", "[tree_traversal]")
+{
+    expression first(binary_op<add>(1, 2));
+    expression second(binary_op<sub>(3, 4));
+
+    // interleaved walks
+    mapbox::util::postorder_cursor<expression> a(first);
+    mapbox::util::postorder_cursor<expression> b(second);
+    std::string result;
+    expression* node_a = a.next();
+    expression* node_b = b.next();
+    while (node_a != nullptr || node_b != nullptr)
+    {
+        if (node_a != nullptr)
+        {
+            result += mapbox::util::apply_visitor(symbol(), *node_a);
+            node_a = a.next();
+        }
+        if (node_b != nullptr)
+        {
+            result += mapbox::util::apply_visitor(symbol(), *node_b);
+            node_b = b.next();
+        }
+    }
+    REQUIRE(result == "1324+-");
+    REQUIRE(a.next() == nullptr);
+
+    // a subtree replaced before its children are visited
+    expression tree(binary_op<add>(binary_op<sub>(5, 3), 1));
+    mapbox::util::preorder_cursor<expression> cursor(tree);
+    result.clear();
+    while (expression* node = cursor.next())
+    {
+        if (node->is<binary_op<sub>>()) *node = 2;
+        result += mapbox::util::apply_visitor(symbol(), *node);
+    }
+    REQUIRE(result == "+21");
+
+    // skip() doesn't descend
+    mapbox::util::preorder_cursor<expression> skipping(tree);
+    REQUIRE(skipping.next() == &tree);
+    skipping.skip();
+    REQUIRE(skipping.next() == nullptr);
+}
+
+TEST_CASE("traversal of deep and unique_ptr trees", "[tree_traversal]")
+{
+    int const n = 100000;
+    expression chain(0);
+    for (int i = 0; i < n; ++i)
+    {
+        chain = binary_op<add>(std::move(chain), 1);
+    }
+
+    std::vector<int> stack;
+    mapbox::util::for_each_postorder(chain, [&stack](expression & node) {
+        mapbox::util::apply_visitor(stack_calculator{stack}, node);
+    });
+    REQUIRE(stack == std::vector<int>{n});
+
+    std::size_t const count = mapbox::util::fold_tree(chain, std::size_t(0), [](std::size_t acc, expression &) {
+        return acc + 1;
+    });
+    REQUIRE(count == 2 * n + 1);
+    mapbox::util::iterative_destroy(chain);
+
+    unique_expression tree(std::unique_ptr<unique_op>(new unique_op));
+    auto & operands = tree.get<std::unique_ptr<unique_op>>()->operands;
+    for (int i = 1; i <= 4; ++i)
+    {
+        operands.push_back(unique_expression(i));
+    }
+    std::vector<int> leaves;
+    mapbox::util::for_each_preorder(tree, [&leaves](unique_expression const& node) {
+        if (node.is<int>()) leaves.push_back(node.get<int>());
+    });
+    REQUIRE(leaves == (std::vector<int>{1, 2, 3, 4}));
+}
+
+TEST_CASE("traversal of trees with shared subtrees", "[tree_traversal]")
+{
+    // (1 + 2) - (1 + 2), both operands are the same node
+    shared_expression const sum(shared_op<add>(1, 2));
+    shared_expression const tree(shared_op<sub>(sum, sum));
+    REQUIRE(sum.get<mapbox::util::shared_recursive_wrapper<shared_op<add>>>().use_count() == 3);
+
+    std::size_t const count = mapbox::util::fold_tree(tree, std::size_t(0), [](std::size_t acc, shared_expression const&) {
+        return acc + 1;
+    });
+    REQUIRE(count == 7);
+
+    int const total = mapbox::util::fold_tree(tree, 0, [](int acc, shared_expression const& node) {
+        return node.is<int>() ? acc + node.get<int>() : acc;
+    });
+    REQUIRE(total == 6);
+
+    std::size_t visited = 0;
+    mapbox::util::for_each_preorder(tree, [&visited](shared_expression const&) { ++visited; });
+    REQUIRE(visited == 7);
+}
@@ -12,6 +12,8 @@
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <type_traits>
+#include <utility>
 
 
 TEST_CASE( "variant can be moved into vector", "[variant]" ) {
@@ -299,3 +301,445 @@ TEST_CASE( "swapping variants should do the right thing", "[variant]" ) {
     REQUIRE(e.which() == 2);
 }
 
+
+struct assign_counter
+{
+    assign_counter() { ++constructed; }
+    assign_counter(assign_counter const&) { ++constructed; }
+    assign_counter(assign_counter &&) { ++constructed; }
+    assign_counter& operator=(assign_counter const&) { ++assigned; return *this; }
+    assign_counter& operator=(assign_counter &&) { ++assigned; return *this; }
+
+    static int constructed;
+    static int assigned;
+};
+
+int assign_counter::constructed = 0;
+int assign_counter::assigned = 0;
+
+TEST_CASE( "assigning the active alternative reuses its storage", "[variant]" ) {
+    using variant_type = mapbox::util::variant<int, assign_counter>;
+    variant_type v0{assign_counter()};
+    variant_type const v1{assign_counter()};
+    assign_counter const value;
+    assign_counter::constructed = 0;
+    assign_counter::assigned = 0;
+
+    SECTION( "copy" ) {
+        v0 = v1;
+        REQUIRE(assign_counter::assigned == 1);
+    }
+
+    SECTION( "copy from a non-const lvalue" ) {
+        variant_type v2{assign_counter()};
+        assign_counter::constructed = 0;
+        v0 = v2;
+        REQUIRE(assign_counter::assigned == 1);
+        REQUIRE(assign_counter::constructed == 0);
+    }
+
+    SECTION( "move" ) {
+        v0 = variant_type{mapbox::util::no_init()};
+        v0 = variant_type{assign_counter()};
+        assign_counter::constructed = 0;
+        v0 = variant_type(v1);
+        REQUIRE(assign_counter::assigned == 1);
+        REQUIRE(assign_counter::constructed == 1); // the temporary only
+    }
+
+    SECTION( "converting" ) {
+        v0 = value;
+        v0 = assign_counter();
+        REQUIRE(assign_counter::assigned == 2);
+        REQUIRE(assign_counter::constructed == 1); // the temporary only
+    }
+
+    SECTION( "type change" ) {
+        v0 = 7;
+        v0 = value;
+        REQUIRE(assign_counter::assigned == 0);
+        REQUIRE(assign_counter::constructed == 2); // temporary, then moved in
+    }
+
+    SECTION( "self assignment" ) {
+        v0 = v0;
+        REQUIRE(v0.is<assign_counter>());
+        REQUIRE(assign_counter::assigned == 1);
+    }
+}
+
+TEST_CASE( "assigning a string over a string keeps its buffer", "[variant]" ) {
+    using variant_type = mapbox::util::variant<int, std::string>;
+    variant_type v(std::string(100, 'x'));
+    void const* buffer = v.get<std::string>().data();
+    std::string const value(50, 'y');
+    v = value;
+    REQUIRE(v.get<std::string>() == value);
+    variant_type const other(std::string(60, 'z'));
+    v = other;
+    REQUIRE(v.get<std::string>() == std::string(60, 'z'));
+    REQUIRE(static_cast<void const*>(v.get<std::string>().data()) == buffer);
+    variant_type mutable_other(std::string(70, 'w'));
+    v = mutable_other;
+    REQUIRE(v.get<std::string>() == std::string(70, 'w'));
+    REQUIRE(static_cast<void const*>(v.get<std::string>().data()) == buffer);
+}
+
+struct immovable
+{
+    immovable(int a_, std::string b_)
+        : a(a_), b(std::move(b_)) {}
+    immovable(immovable const&) = delete;
+    immovable& operator=(immovable const&) = delete;
+
+    int a;
+    std::string b;
+};
+
+TEST_CASE( "alternatives can be constructed in place", "[variant]" ) {
+    using variant_type = mapbox::util::variant<int, immovable, std::string>;
+
+    SECTION( "in_place_type_t constructor" ) {
+        variant_type v(mapbox::util::in_place_type_t<immovable>(), 1, "foo");
+        REQUIRE(v.is<immovable>());
+        REQUIRE(v.get<immovable>().a == 1);
+        REQUIRE(v.get<immovable>().b == "foo");
+    }
+
+    SECTION( "in_place_index_t constructor" ) {
+        variant_type v(mapbox::util::in_place_index_t<2>(), 3u, 'x');
+        REQUIRE(v.which() == 2);
+        REQUIRE(v.get<std::string>() == "xxx");
+        variant_type w(mapbox::util::in_place_index_t<1>(), 2, "bar");
+        REQUIRE(w.which() == 1);
+        REQUIRE(w.get<immovable>().a == 2);
+    }
+
+    SECTION( "emplace by type" ) {
+        variant_type v;
+        immovable & ref = v.emplace<immovable>(4, "baz");
+        REQUIRE(&ref == &v.get<immovable>());
+        REQUIRE(ref.b == "baz");
+        std::string & str = v.emplace<std::string>(2u, 'y');
+        REQUIRE(str == "yy");
+        REQUIRE(v.is<std::string>());
+    }
+
+    SECTION( "emplace by index" ) {
+        variant_type v;
+        immovable & ref = v.emplace<1>(5, "qux");
+        REQUIRE(&ref == &v.get<immovable>());
+        REQUIRE(v.which() == 1);
+        int & i = v.emplace<0>(42);
+        REQUIRE(i == 42);
+        REQUIRE(v.get<int>() == 42);
+    }
+}
+
+// libstdc++ before gcc 5 has no is_trivially_* traits, variant can't detect
+// trivial alternatives there
+#ifndef VARIANT_NO_TRIVIALITY_TRAITS
+TEST_CASE( "variant of trivial alternatives is trivially copyable", "[variant]" ) {
+    using trivial_type = mapbox::util::variant<int, double, bool>;
+    REQUIRE(std::is_trivially_copyable<trivial_type>::value);
+    REQUIRE(std::is_trivially_destructible<trivial_type>::value);
+    REQUIRE(std::is_trivially_copy_constructible<trivial_type>::value);
+    REQUIRE(std::is_trivially_move_assignable<trivial_type>::value);
+
+    using string_type = mapbox::util::variant<int, std::string>;
+    REQUIRE(!std::is_trivially_copyable<string_type>::value);
+    REQUIRE(!std::is_trivially_destructible<string_type>::value);
+    REQUIRE(std::is_nothrow_move_constructible<string_type>::value);
+
+    trivial_type a(3.5);
+    trivial_type b(true);
+    b = a;
+    REQUIRE(b.get<double>() == Approx(3.5));
+    trivial_type c(a);
+    REQUIRE(c.get<double>() == Approx(3.5));
+    trivial_type d(mapbox::util::no_init{});
+    c = d;
+    REQUIRE(!c.valid());
+}
+#endif
+
+TEST_CASE( "variants are relocated in bulk", "[variant]" ) {
+    using mapbox::util::is_trivially_relocatable;
+    using unique_type = mapbox::util::variant<int, std::unique_ptr<int>, mapbox::util::recursive_wrapper<std::string>>;
+    using string_type = mapbox::util::variant<int, std::string>;
+    REQUIRE((is_trivially_relocatable<mapbox::util::variant<int, double>>::value));
+    REQUIRE(is_trivially_relocatable<unique_type>::value);
+#ifndef _LIBCPP_VERSION
+    REQUIRE(!is_trivially_relocatable<string_type>::value);
+#endif
+
+    SECTION( "trivially relocatable" ) {
+        using storage_type = std::aligned_storage<sizeof(unique_type), alignof(unique_type)>::type;
+        storage_type src[3];
+        storage_type dest[3];
+        unique_type* first = reinterpret_cast<unique_type*>(src);
+        new (first) unique_type(1);
+        new (first + 1) unique_type(std::unique_ptr<int>(new int(2)));
+        new (first + 2) unique_type(mapbox::util::recursive_wrapper<std::string>("three"));
+        unique_type* d_first = reinterpret_cast<unique_type*>(dest);
+        REQUIRE(mapbox::util::uninitialized_relocate_n(first, 3, d_first) == d_first + 3);
+        REQUIRE(d_first[0].get<int>() == 1);
+        REQUIRE(*d_first[1].get<std::unique_ptr<int>>() == 2);
+        REQUIRE(d_first[2].get<std::string>() == "three");
+        for (std::size_t i = 0; i < 3; ++i) d_first[i].~unique_type();
+    }
+
+    SECTION( "move and destroy" ) {
+        using storage_type = std::aligned_storage<sizeof(string_type), alignof(string_type)>::type;
+        storage_type src[2];
+        storage_type dest[2];
+        string_type* first = reinterpret_cast<string_type*>(src);
+        new (first) string_type(1);
+        new (first + 1) string_type(std::string("two"));
+        string_type* d_first = reinterpret_cast<string_type*>(dest);
+        REQUIRE(mapbox::util::uninitialized_relocate_n(first, 2, d_first) == d_first + 2);
+        REQUIRE(d_first[0].get<int>() == 1);
+        REQUIRE(d_first[1].get<std::string>() == "two");
+        for (std::size_t i = 0; i < 2; ++i) d_first[i].~string_type();
+    }
+}
+
+TEST_CASE( "type index is stored in the narrowest type", "[variant]" ) {
+    REQUIRE(sizeof(mapbox::util::variant<bool, std::int32_t>) == 2 * sizeof(std::int32_t));
+    REQUIRE(sizeof(mapbox::util::variant<bool, char>) == 2);
+    REQUIRE(sizeof(mapbox::util::variant<double, std::int64_t>) == 2 * sizeof(double));
+
+    mapbox::util::variant<bool, std::int32_t> v(std::int32_t(7));
+    REQUIRE(v.get_type_index() == 0);
+    REQUIRE(v.which() == 1);
+    mapbox::util::variant<bool, std::int32_t> invalid{mapbox::util::no_init()};
+    REQUIRE(invalid.get_type_index() == mapbox::util::detail::invalid_value);
+    REQUIRE(!invalid.valid());
+}
+
+struct large_geometry
+{
+    double coords[12];
+};
+
+struct geometry_visitor
+{
+    double operator()(double value) const
+    {
+        return value;
+    }
+
+    double operator()(large_geometry & geom) const
+    {
+        geom.coords[0] += 1.0;
+        return geom.coords[0];
+    }
+};
+
+TEST_CASE( "boxed_variant moves large alternatives to the heap", "[variant]" ) {
+    using variant_type = mapbox::util::boxed_variant<sizeof(double), double, large_geometry>;
+    REQUIRE((std::is_same<variant_type, mapbox::util::variant<double, mapbox::util::recursive_wrapper<large_geometry>>>::value));
+    REQUIRE(sizeof(variant_type) == 2 * sizeof(double));
+
+    large_geometry geom = {};
+    geom.coords[0] = 1.0;
+    variant_type v(geom);
+    REQUIRE(v.is<large_geometry>());
+    REQUIRE(!v.is<double>());
+    REQUIRE(v.get<large_geometry>().coords[0] == Approx(1.0));
+    REQUIRE(mapbox::util::apply_visitor(geometry_visitor(), v) == Approx(2.0));
+    REQUIRE(v.get<large_geometry>().coords[0] == Approx(2.0));
+
+    variant_type copy(v);
+    REQUIRE(&copy.get<large_geometry>() != &v.get<large_geometry>());
+    REQUIRE(copy.get<large_geometry>().coords[0] == Approx(2.0));
+
+    v = 3.5;
+    REQUIRE(v.is<double>());
+    REQUIRE(mapbox::util::apply_visitor(geometry_visitor(), v) == Approx(3.5));
+}
+
+struct which_visitor
+{
+    template <typename T>
+    int operator()(T const&) const
+    {
+        return sizeof(T) == sizeof(char) ? -1 : static_cast<int>(sizeof(T));
+    }
+
+    int operator()(std::string const&) const
+    {
+        return 0;
+    }
+};
+
+TEST_CASE( "visitation dispatches to every alternative", "[visitor][unary visitor]" ) {
+    using variant_type = mapbox::util::variant<char, std::int16_t, std::int32_t, std::int64_t, std::string>;
+    std::vector<variant_type> vec = {char('a'), std::int16_t(1), std::int32_t(2), std::int64_t(3), std::string("foo")};
+    std::vector<int> result;
+    for (auto const& v : vec)
+    {
+        result.push_back(mapbox::util::apply_visitor(which_visitor(), v));
+    }
+    REQUIRE(result == (std::vector<int>{-1, 2, 4, 8, 0}));
+}
+
+TEST_CASE( "visiting an invalid variant throws", "[visitor][unary visitor]" ) {
+    using variant_type = mapbox::util::variant<int, double, std::string>;
+    variant_type var{mapbox::util::no_init()};
+    REQUIRE_FALSE(var.valid());
+    REQUIRE_THROWS(mapbox::util::apply_visitor(which_visitor(), var));
+    variant_type const& cref = var;
+    REQUIRE_THROWS(mapbox::util::apply_visitor(which_visitor(), cref));
+}
+
+struct pair_visitor
+{
+    template <typename T0, typename T1>
+    std::string operator()(T0 const& lhs, T1 const& rhs) const
+    {
+        std::ostringstream out;
+        out << lhs << ":" << rhs;
+        return out.str();
+    }
+};
+
+TEST_CASE( "binary visitation dispatches to every pair of alternatives", "[visitor][binary visitor]" ) {
+    using variant_type = mapbox::util::variant<int, double, std::string>;
+    std::vector<variant_type> vec = {1, 2.5, std::string("foo")};
+    std::vector<std::string> result;
+    for (auto const& lhs : vec)
+    {
+        for (auto const& rhs : vec)
+        {
+            result.push_back(mapbox::util::apply_visitor(pair_visitor(), lhs, rhs));
+        }
+    }
+    REQUIRE(result == (std::vector<std::string>{"1:1", "1:2.5", "1:foo",
+                                                "2.5:1", "2.5:2.5", "2.5:foo",
+                                                "foo:1", "foo:2.5", "foo:foo"}));
+    variant_type invalid{mapbox::util::no_init()};
+    REQUIRE_THROWS(mapbox::util::apply_visitor(pair_visitor(), vec[0], invalid));
+    REQUIRE_THROWS(mapbox::util::apply_visitor(pair_visitor(), invalid, vec[0]));
+    REQUIRE_THROWS(mapbox::util::apply_visitor(pair_visitor(), invalid, invalid));
+}
+
+struct triple_visitor
+{
+    template <typename T0, typename T1, typename T2>
+    std::string operator()(T0 const& v0, T1 const& v1, T2 const& v2) const
+    {
+        std::ostringstream out;
+        out << v0 << ":" << v1 << ":" << v2;
+        return out.str();
+    }
+};
+
+struct incrementing_visitor
+{
+    template <typename T0, typename T1, typename T2>
+    void operator()(T0 & v0, T1 const&, T2 & v2) const
+    {
+        ++v0;
+        ++v2;
+    }
+};
+
+TEST_CASE( "n-ary visitation over variants of different types", "[visitor][n-ary visitor]" ) {
+    using variant_type0 = mapbox::util::variant<int, std::string>;
+    using variant_type1 = mapbox::util::variant<bool, double, std::string>;
+    using variant_type2 = mapbox::util::variant<std::int64_t>;
+
+    std::vector<variant_type0> vec0 = {1, std::string("foo")};
+    std::vector<variant_type1> vec1 = {false, 2.5, std::string("bar")};
+    variant_type2 const v2 = std::int64_t(3);
+    std::vector<std::string> result;
+    for (auto const& v0 : vec0)
+    {
+        for (auto const& v1 : vec1)
+        {
+            result.push_back(mapbox::util::apply_visitor(triple_visitor(), v0, v1, v2));
+        }
+    }
+    REQUIRE(result == (std::vector<std::string>{"1:0:3", "1:2.5:3", "1:bar:3",
+                                                "foo:0:3", "foo:2.5:3", "foo:bar:3"}));
+
+    SECTION( "two variants of different types" ) {
+        REQUIRE(mapbox::util::apply_visitor(pair_visitor(), vec0[1], vec1[1]) == "foo:2.5");
+    }
+
+    SECTION( "mixed constness" ) {
+        mapbox::util::variant<int, double> v0 = 1;
+        variant_type1 const v1 = 2.5;
+        mapbox::util::variant<int, double> v3 = 4.5;
+        mapbox::util::apply_visitor(incrementing_visitor(), v0, v1, v3);
+        REQUIRE(v0.get<int>() == 2);
+        REQUIRE(v3.get<double>() == Approx(5.5));
+    }
+
+    SECTION( "invalid variant throws" ) {
+        variant_type1 invalid{mapbox::util::no_init()};
+        REQUIRE_THROWS(mapbox::util::apply_visitor(triple_visitor(), vec0[0], invalid, v2));
+    }
+}
+
+template <typename F, typename... Args>
+auto visitable(int) -> decltype(mapbox::util::apply_visitor(std::declval<F>(), std::declval<Args>()...), std::true_type());
+
+template <typename F, typename... Args>
+std::false_type visitable(...);
+
+TEST_CASE( "n-ary apply_visitor only takes variants", "[visitor][n-ary visitor]" ) {
+    using variant_type = mapbox::util::variant<int, std::string>;
+    REQUIRE((decltype(visitable<triple_visitor, variant_type, variant_type, variant_type>(0))::value));
+    REQUIRE((decltype(visitable<triple_visitor, variant_type const&, variant_type &&, variant_type &>(0))::value));
+    REQUIRE(!(decltype(visitable<triple_visitor, variant_type, int, variant_type>(0))::value));
+    REQUIRE(!(decltype(visitable<triple_visitor, int, int, int>(0))::value));
+}
+
+template <typename Strategy>
+struct strategy_visitor : which_visitor
+{
+    using dispatch_strategy = Strategy;
+};
+
+template <typename Strategy>
+void check_strategy()
+{
+    using variant_type = mapbox::util::variant<char, std::int16_t, std::int32_t, std::int64_t, std::string>;
+    std::vector<variant_type> vec = {char('a'), std::int16_t(1), std::int32_t(2), std::int64_t(3), std::string("foo")};
+    std::vector<int> result;
+    for (auto & v : vec)
+    {
+        result.push_back(mapbox::util::apply_visitor(strategy_visitor<Strategy>(), v));
+        variant_type const& cref = v;
+        result.push_back(mapbox::util::apply_visitor(strategy_visitor<Strategy>(), cref));
+    }
+    REQUIRE(result == (std::vector<int>{-1, -1, 2, 2, 4, 4, 8, 8, 0, 0}));
+    variant_type invalid{mapbox::util::no_init()};
+    REQUIRE_THROWS(mapbox::util::apply_visitor(strategy_visitor<Strategy>(), invalid));
+}
+
+TEST_CASE( "all dispatch strategies visit the same alternative", "[visitor][unary visitor]" ) {
+    SECTION( "linear" ) {
+        check_strategy<mapbox::util::linear_dispatch>();
+    }
+    SECTION( "binary search" ) {
+        check_strategy<mapbox::util::binary_search_dispatch>();
+    }
+    SECTION( "table" ) {
+        check_strategy<mapbox::util::table_dispatch>();
+    }
+    SECTION( "priority" ) {
+        check_strategy<mapbox::util::priority_dispatch<std::string, std::int32_t>>();
+    }
+}
+
+TEST_CASE( "default dispatch strategy depends on the number of alternatives", "[visitor][unary visitor]" ) {
+    using mapbox::util::dispatch_strategy;
+    using mapbox::util::variant;
+    REQUIRE((std::is_same<dispatch_strategy<variant<int, double>>::type, mapbox::util::linear_dispatch>::value));
+    REQUIRE((std::is_same<dispatch_strategy<variant<char, short, int, long>>::type, mapbox::util::binary_search_dispatch>::value));
+    REQUIRE((std::is_same<dispatch_strategy<variant<char, short, int, long, long long, float, double, long double, bool>>::type,
+                          mapbox::util::table_dispatch>::value));
+}
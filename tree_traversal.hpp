@@ -0,0 +1,222 @@
+#ifndef MAPBOX_UTIL_TREE_TRAVERSAL_HPP
+#define MAPBOX_UTIL_TREE_TRAVERSAL_HPP
+
+#include <algorithm>
+#include <cstddef> // size_t, ptrdiff_t
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "recursive_traits.hpp"
+#include "variant.hpp"
+
+// Pre-order and post-order traversal of recursive variant trees with an
+// explicit stack, so the walk can be as deep as the tree is and may be
+// paused, resumed or interleaved with other work.
+//
+// tree_cursor<V, Order> hands out the nodes of a tree one by one; next()
+// returns the next node, or nullptr when the walk is done:
+//
+//     preorder_cursor<expression const> cursor(tree);
+//     while (expression const* node = cursor.next())
+//     {
+//         apply_visitor(printer(), *node);
+//     }
+//
+// Children are listed by recursive_children<T>, see recursive_traits.hpp,
+// so any wrapper supported there works. Trees with shared nodes
+// (shared_recursive_wrapper) can only be walked as const: mutable access
+// to a shared node would clone it, and skipping its children would give
+// partial results.
+//
+// Pre-order cursors read the children of a node when advancing past it, so
+// the node returned last may be changed (e.g. a subtree replaced by a
+// leaf) before its children are visited, and skip() doesn't descend into
+// it at all.
+//
+// Unless Prefetch is false, the nodes of the children are prefetched as
+// they are put on the stack, so loading them overlaps with the work done
+// on the current node.
+//
+// for_each_preorder(), for_each_postorder() and fold_tree() walk the whole
+// tree with a cursor.
+
+namespace mapbox { namespace util {
+
+enum class traversal_order
+{
+    pre,
+    post
+};
+
+namespace detail {
+
+inline void prefetch(void const* address)
+{
+#if defined(__GNUC__)
+    __builtin_prefetch(address);
+#else
+    (void)address;
+#endif
+}
+
+class node_prefetcher
+{
+public:
+    template <typename W>
+    void operator()(W const& alternative) const
+    {
+        prefetch(owned_node<W>::get(alternative));
+    }
+};
+
+template <typename V>
+VARIANT_INLINE void prefetch_node(V const& tree, std::true_type)
+{
+    node_prefetcher prefetcher;
+    apply_to_alternative<V const, node_prefetcher>::apply(tree, prefetcher);
+}
+
+template <typename V>
+VARIANT_INLINE void prefetch_node(V const&, std::false_type) {}
+
+} // namespace detail
+
+template <typename V, traversal_order Order, bool Prefetch = true>
+class tree_cursor;
+
+template <typename V, bool Prefetch>
+class tree_cursor<V, traversal_order::pre, Prefetch>
+{
+    static_assert(std::is_const<V>::value || !detail::has_shared_nodes<V>::value,
+                  "Trees with shared nodes can only be walked as const, e.g. tree_cursor<V const, Order>");
+
+public:
+    explicit tree_cursor(V & tree)
+        : pending_{&tree},
+          last_(nullptr) {}
+
+    // the next node, nullptr when done
+    V* next()
+    {
+        if (last_ != nullptr) push_children(*last_);
+        if (pending_.empty())
+        {
+            last_ = nullptr;
+            return nullptr;
+        }
+        last_ = pending_.back();
+        pending_.pop_back();
+        return last_;
+    }
+
+    // don't visit the children of the node returned last
+    void skip()
+    {
+        last_ = nullptr;
+    }
+
+private:
+    void push_children(V & node)
+    {
+        std::size_t const first = pending_.size();
+        for_each_child(node, [this](V & child) {
+            detail::prefetch_node(child, std::integral_constant<bool, Prefetch>());
+            pending_.push_back(&child);
+        });
+        // the first child goes on top
+        std::reverse(pending_.begin() + static_cast<std::ptrdiff_t>(first), pending_.end());
+    }
+
+    std::vector<V*> pending_;
+    V* last_;
+};
+
+template <typename V, bool Prefetch>
+class tree_cursor<V, traversal_order::post, Prefetch>
+{
+    static_assert(std::is_const<V>::value || !detail::has_shared_nodes<V>::value,
+                  "Trees with shared nodes can only be walked as const, e.g. tree_cursor<V const, Order>");
+
+public:
+    explicit tree_cursor(V & tree)
+        : pending_{entry{&tree, false}} {}
+
+    // the next node, nullptr when done
+    V* next()
+    {
+        while (!pending_.empty())
+        {
+            entry & current = pending_.back();
+            if (current.expanded)
+            {
+                V* node = current.node;
+                pending_.pop_back();
+                return node;
+            }
+            // a node stays on the stack, marked expanded, below its children
+            current.expanded = true;
+            V* node = current.node;
+            std::size_t const first = pending_.size();
+            for_each_child(*node, [this](V & child) {
+                detail::prefetch_node(child, std::integral_constant<bool, Prefetch>());
+                pending_.push_back(entry{&child, false});
+            });
+            std::reverse(pending_.begin() + static_cast<std::ptrdiff_t>(first), pending_.end());
+        }
+        return nullptr;
+    }
+
+private:
+    struct entry
+    {
+        V* node;
+        bool expanded;
+    };
+
+    std::vector<entry> pending_;
+};
+
+template <typename V, bool Prefetch = true>
+using preorder_cursor = tree_cursor<V, traversal_order::pre, Prefetch>;
+
+template <typename V, bool Prefetch = true>
+using postorder_cursor = tree_cursor<V, traversal_order::post, Prefetch>;
+
+// calls f(node) for each node, parents before their children
+template <typename V, typename F>
+void for_each_preorder(V & tree, F && f)
+{
+    preorder_cursor<V> cursor(tree);
+    while (V* node = cursor.next())
+    {
+        f(*node);
+    }
+}
+
+// calls f(node) for each node, children before their parents
+template <typename V, typename F>
+void for_each_postorder(V & tree, F && f)
+{
+    postorder_cursor<V> cursor(tree);
+    while (V* node = cursor.next())
+    {
+        f(*node);
+    }
+}
+
+// acc = f(std::move(acc), node) for each node in post-order, returns acc
+template <typename V, typename Acc, typename F>
+Acc fold_tree(V & tree, Acc acc, F && f)
+{
+    postorder_cursor<V> cursor(tree);
+    while (V* node = cursor.next())
+    {
+        acc = f(std::move(acc), *node);
+    }
+    return acc;
+}
+
+}}
+
+#endif // MAPBOX_UTIL_TREE_TRAVERSAL_HPP
@@ -8,10 +8,22 @@
       "type": "executable",
       "sources": [
         "test/unit.cpp",
+        "test/t/arena.cpp",
+        "test/t/flat_tree.cpp",
+        "test/t/hash_cons.cpp",
         "test/t/issue21.cpp",
         "test/t/mutating_visitor.cpp",
+        "test/t/nan_box.cpp",
         "test/t/optional.cpp",
+        "test/t/pointer_variant.cpp",
+        "test/t/pool_allocator.cpp",
+        "test/t/postfix_program.cpp",
+        "test/t/recursive_traits.cpp",
         "test/t/recursive_wrapper.cpp",
+        "test/t/shared_recursive_wrapper.cpp",
+        "test/t/shared_string.cpp",
+        "test/t/small_string.cpp",
+        "test/t/tree_traversal.cpp",
         "test/t/variant.cpp"
       ],
       "xcode_settings": {
@@ -22,6 +34,25 @@
           "./",
           "test/include"
       ]
+    },
+    {
+      "target_name": "dispatch_profile_tests",
+      "type": "executable",
+      "sources": [
+        "test/unit.cpp",
+        "test/dispatch_profile_test.cpp"
+      ],
+      "defines": [
+        "VARIANT_PROFILE_DISPATCH"
+      ],
+      "xcode_settings": {
+        "SDKROOT": "macosx",
+        "SUPPORTED_PLATFORMS":["macosx"]
+      },
+      "include_dirs": [
+          "./",
+          "test/include"
+      ]
     }
   ]
 }
@@ -2,6 +2,9 @@
 #define MAPBOX_UTIL_VARIANT_HPP
 
 #include <cstddef> // size_t
+#include <cstdint> // int8_t
+#include <cstring> // memcpy
+#include <memory> // unique_ptr
 #include <new> // operator new
 #include <stdexcept> // runtime_error
 #include <string>
@@ -12,6 +15,10 @@
 
 #include "recursive_wrapper.hpp"
 
+#ifdef VARIANT_PROFILE_DISPATCH
+#include <atomic>
+#endif
+
 #ifdef _MSC_VER
  // https://msdn.microsoft.com/en-us/library/bw1hbe6y.aspx
  #ifdef NDEBUG
@@ -27,6 +34,14 @@
  #endif
 #endif
 
+// libstdc++ before gcc 5 lacks the std::is_trivially_* family. Its
+// __GLIBCXX__ date can't tell (4.8.5 and 4.9.x were released after 5.1), but
+// _GLIBCXX_USE_CXX11_ABI is only defined from gcc 5 on.
+#if (defined(__GNUC__) && !defined(__clang__) && __GNUC__ < 5) || \
+    (defined(__GLIBCXX__) && !defined(_GLIBCXX_USE_CXX11_ABI))
+ #define VARIANT_NO_TRIVIALITY_TRAITS
+#endif
+
 #define VARIANT_MAJOR_VERSION 0
 #define VARIANT_MINOR_VERSION 1
 #define VARIANT_PATCH_VERSION 0
@@ -58,10 +73,74 @@ protected:
     ~static_visitor() {}
 };
 
+template <typename... Types>
+class variant;
+
+// dispatch strategies for unary visitation
+struct linear_dispatch {};        // compares type_index against each alternative in turn
+struct binary_search_dispatch {}; // balanced binary search, log2(N) compares
+struct table_dispatch {};         // single indirect call through a table of thunks
+
+// Checks the listed alternatives first, in the given order, then falls back
+// to the default strategy for the variant. Only the order of the checks
+// changes; which() and get_type_index() are unaffected.
+template <typename... Hot>
+struct priority_dispatch {};
+
+// Selects the dispatch strategy used to visit V. Specialize it for a variant
+// type to change the strategy of all visits of that type, or give a visitor a
+// nested `dispatch_strategy` type to change it for that visitor only.
+template <typename V>
+struct dispatch_strategy;
+
+namespace detail {
+
+// The default follows test/bench_dispatch.cpp: a binary search beats the
+// linear chain from three alternatives on, and the table wins past eight.
+template <std::size_t N>
+struct default_dispatch_strategy
+{
+    using type = typename std::conditional<(N <= 2), linear_dispatch,
+                 typename std::conditional<(N <= 8), binary_search_dispatch,
+                                           table_dispatch>::type>::type;
+};
+
+} // namespace detail
+
+template <typename... Types>
+struct dispatch_strategy<variant<Types...>>
+    : detail::default_dispatch_strategy<sizeof...(Types)> {};
+
 namespace detail {
 
 static constexpr std::size_t invalid_value = std::size_t(-1);
 
+template <typename V>
+struct variant_traits;
+
+template <typename... Types>
+struct variant_traits<variant<Types...>>
+{
+    static constexpr std::size_t size = sizeof...(Types);
+    using types = std::tuple<Types...>;
+    using first_type = typename std::tuple_element<0, types>::type;
+};
+
+template <typename V>
+struct variant_traits<V const> : variant_traits<V> {};
+
+template <typename V>
+struct variant_traits<V &> : variant_traits<V> {};
+
+template <typename V>
+struct variant_traits<V &&> : variant_traits<V> {};
+
+template <typename T>
+struct is_variant : std::false_type {};
+
+template <typename... Types>
+struct is_variant<variant<Types...>> : std::true_type {};
+
 template <typename T, typename... Types>
 struct direct_type;
 
@@ -116,6 +195,59 @@ struct has_type<T, First, Types...>
 template <typename T>
 struct has_type<T> : std::false_type {};
 
+// the T held on the heap by a wrapper W, e.g. recursive_wrapper<T, Alloc>,
+// void if W isn't such a wrapper; specialized for other wrappers along with
+// unwrapper
+template <typename W>
+struct boxed_type
+{
+    using type = void;
+};
+
+template <typename T, typename Alloc>
+struct boxed_type<recursive_wrapper<T, Alloc>>
+{
+    using type = T;
+};
+
+template <typename W>
+struct is_boxed : std::integral_constant<bool, !std::is_void<typename boxed_type<W>::type>::value> {};
+
+template <typename W, std::size_t I>
+struct wrapper_index
+{
+    static constexpr std::size_t index = I;
+    using type = W;
+};
+
+// index and type of the wrapper holding T in Types...
+template <typename T, typename... Types>
+struct wrapped_type;
+
+template <typename T, typename First, typename... Types>
+struct wrapped_type<T, First, Types...>
+    : std::conditional<std::is_same<typename boxed_type<First>::type, T>::value,
+                       wrapper_index<First, sizeof...(Types)>,
+                       wrapped_type<T, Types...>>::type {};
+
+template <typename T>
+struct wrapped_type<T> : wrapper_index<void, invalid_value> {};
+
+// index of T in Types..., or of its wrapper if T is held boxed
+template <typename T, typename... Types>
+struct held_type
+{
+    static constexpr std::size_t index = (direct_type<T, Types...>::index != invalid_value)
+        ? direct_type<T, Types...>::index : wrapped_type<T, Types...>::index;
+};
+
+// boxes T when it is larger than Threshold bytes, see boxed_variant
+template <typename T, std::size_t Threshold>
+struct box_if_larger
+{
+    using type = typename std::conditional<(sizeof(T) > Threshold), recursive_wrapper<T>, T>::type;
+};
+
 template <typename T, typename... Types>
 struct is_valid_type;
 
@@ -140,9 +272,9 @@ struct result_of_unary_visit
 };
 
 template <typename F, typename V>
-struct result_of_unary_visit<F, V, typename enable_if_type<typename F::result_type>::type >
+struct result_of_unary_visit<F, V, typename enable_if_type<typename std::remove_reference<F>::type::result_type>::type >
 {
-    using type = typename F::result_type;
+    using type = typename std::remove_reference<F>::type::result_type;
 };
 
 template <typename F, typename V, typename Enable = void>
@@ -153,9 +285,36 @@ struct result_of_binary_visit
 
 
 template <typename F, typename V>
-struct result_of_binary_visit<F, V, typename enable_if_type<typename F::result_type>::type >
+struct result_of_binary_visit<F, V, typename enable_if_type<typename std::remove_reference<F>::type::result_type>::type >
+{
+    using type = typename std::remove_reference<F>::type::result_type;
+};
+
+template <typename F, typename Enable, typename... Vs>
+struct result_of_multi_visit_impl
+{
+    using type = typename std::result_of<F(typename variant_traits<Vs>::first_type &...)>::type;
+};
+
+template <typename F, typename... Vs>
+struct result_of_multi_visit_impl<F, typename enable_if_type<typename std::remove_reference<F>::type::result_type>::type, Vs...>
+{
+    using type = typename std::remove_reference<F>::type::result_type;
+};
+
+template <typename F, typename... Vs>
+struct result_of_multi_visit : result_of_multi_visit_impl<F, void, Vs...> {};
+
+template <typename F, typename V, typename Enable = void>
+struct visitor_dispatch_strategy
+{
+    using type = typename dispatch_strategy<V>::type;
+};
+
+template <typename F, typename V>
+struct visitor_dispatch_strategy<F, V, typename enable_if_type<typename std::remove_reference<F>::type::dispatch_strategy>::type >
 {
-    using type = typename F::result_type;
+    using type = typename std::remove_reference<F>::type::dispatch_strategy;
 };
 
 
@@ -177,6 +336,68 @@ struct static_max<arg1, arg2, others...>
         static_max<arg2, others...>::value;
 };
 
+template <std::size_t... Is>
+struct index_sequence {};
+
+template <typename S0, typename S1>
+struct concat_index_sequence;
+
+template <std::size_t... I0, std::size_t... I1>
+struct concat_index_sequence<index_sequence<I0...>, index_sequence<I1...>>
+{
+    using type = index_sequence<I0..., (sizeof...(I0) + I1)...>;
+};
+
+// logarithmic instantiation depth, the binary dispatch table needs
+// (sizeof...(Types) + 1)^2 indices
+template <std::size_t N>
+struct make_index_sequence_impl
+{
+    using type = typename concat_index_sequence<
+        typename make_index_sequence_impl<N / 2>::type,
+        typename make_index_sequence_impl<N - N / 2>::type>::type;
+};
+
+template <>
+struct make_index_sequence_impl<0>
+{
+    using type = index_sequence<>;
+};
+
+template <>
+struct make_index_sequence_impl<1>
+{
+    using type = index_sequence<0>;
+};
+
+template <std::size_t N>
+using make_index_sequence = typename make_index_sequence_impl<N>::type;
+
+template <std::size_t... args>
+struct static_product;
+
+template <>
+struct static_product<>
+{
+    static const std::size_t value = 1;
+};
+
+template <std::size_t arg, std::size_t... others>
+struct static_product<arg, others...>
+{
+    static const std::size_t value = arg * static_product<others...>::value;
+};
+
+template <bool... args>
+struct static_all;
+
+template <>
+struct static_all<> : std::true_type {};
+
+template <bool arg, bool... others>
+struct static_all<arg, others...>
+    : std::integral_constant<bool, arg && static_all<others...>::value> {};
+
 template <typename... Types>
 struct variant_helper;
 
@@ -199,10 +420,9 @@ struct variant_helper<T, Types...>
     {
         if (old_id == sizeof...(Types))
         {
+            // the source stays alive and is destroyed later, so this can't
+            // be a memcpy even for relocatable types, see uninitialized_relocate_n
             new (new_value) T(std::move(*reinterpret_cast<T*>(old_value)));
-            //std::memcpy(new_value, old_value, sizeof(T));
-            // ^^  DANGER: this should only be considered for relocatable types e.g built-in types
-            // Also, I don't see any measurable performance benefit just yet
         }
         else
         {
@@ -222,6 +442,48 @@ struct variant_helper<T, Types...>
         }
     }
 
+    // both old_value and new_value hold the alternative with id, reuse the
+    // existing object (and its resources) via its own assignment operator
+    VARIANT_INLINE static void copy_assign(const std::size_t id, const void * old_value, void * new_value)
+    {
+        if (id == sizeof...(Types))
+        {
+            assign(*reinterpret_cast<T*>(new_value), *reinterpret_cast<const T*>(old_value),
+                   std::is_copy_assignable<T>());
+        }
+        else
+        {
+            variant_helper<Types...>::copy_assign(id, old_value, new_value);
+        }
+    }
+
+    VARIANT_INLINE static void move_assign(const std::size_t id, void * old_value, void * new_value)
+    {
+        if (id == sizeof...(Types))
+        {
+            assign(*reinterpret_cast<T*>(new_value), std::move(*reinterpret_cast<T*>(old_value)),
+                   std::is_move_assignable<T>());
+        }
+        else
+        {
+            variant_helper<Types...>::move_assign(id, old_value, new_value);
+        }
+    }
+
+    template <typename U>
+    VARIANT_INLINE static void assign(T & lhs, U && rhs, std::true_type)
+    {
+        lhs = std::forward<U>(rhs);
+    }
+
+    // not assignable (e.g. const members), destroy and reconstruct in place
+    template <typename U>
+    VARIANT_INLINE static void assign(T & lhs, U && rhs, std::false_type)
+    {
+        lhs.~T();
+        new (&lhs) T(std::forward<U>(rhs));
+    }
+
     VARIANT_INLINE static void direct_swap(const std::size_t id, void * lhs, void * rhs)
     {
         using std::swap; //enable ADL
@@ -243,29 +505,339 @@ struct variant_helper<>
     VARIANT_INLINE static void destroy(const std::size_t, void *) {}
     VARIANT_INLINE static void move(const std::size_t, void *, void *) {}
     VARIANT_INLINE static void copy(const std::size_t, const void *, void *) {}
+    VARIANT_INLINE static void copy_assign(const std::size_t, const void *, void *) {}
+    VARIANT_INLINE static void move_assign(const std::size_t, void *, void *) {}
     VARIANT_INLINE static void direct_swap(const std::size_t, void *, void *) {}
 };
 
+// Traits deciding which special members of variant<Types...> can be left
+// trivial. Without the std::is_trivially_* family (see
+// VARIANT_NO_TRIVIALITY_TRAITS) fall back to std::is_trivial, which never
+// claims triviality that isn't there.
+#ifdef VARIANT_NO_TRIVIALITY_TRAITS
+template <typename T>
+struct is_trivially_destructible : std::is_trivial<T> {};
+template <typename T>
+struct is_trivially_copy_constructible : std::is_trivial<T> {};
+template <typename T>
+struct is_trivially_move_constructible : std::is_trivial<T> {};
+template <typename T>
+struct is_trivially_copy_assignable : std::is_trivial<T> {};
+template <typename T>
+struct is_trivially_move_assignable : std::is_trivial<T> {};
+#else
+using std::is_trivially_destructible;
+using std::is_trivially_copy_constructible;
+using std::is_trivially_move_constructible;
+using std::is_trivially_copy_assignable;
+using std::is_trivially_move_assignable;
+#endif
+
+// Trait<T> for trivially destructible T, false otherwise. recursive_wrapper<T>
+// converts from T, so asking whether it is trivially copyable needs T to be
+// complete, which it isn't when the variant is instantiated before T is.
+// Its destructor tells the answer without looking at T.
+template <template <typename> class Trait, typename T>
+struct trivially_destructible_and
+    : std::conditional<is_trivially_destructible<T>::value, Trait<T>, std::false_type>::type {};
+
+template <typename... Types>
+struct variant_triviality
+{
+    static constexpr bool destroy = static_all<is_trivially_destructible<Types>::value...>::value;
+    static constexpr bool copy_construct = destroy
+        && static_all<trivially_destructible_and<is_trivially_copy_constructible, Types>::value...>::value;
+    static constexpr bool move_construct = destroy
+        && static_all<trivially_destructible_and<is_trivially_move_constructible, Types>::value...>::value;
+    static constexpr bool copy_assign = copy_construct
+        && static_all<trivially_destructible_and<is_trivially_copy_assignable, Types>::value...>::value;
+    static constexpr bool move_assign = move_construct
+        && static_all<trivially_destructible_and<is_trivially_move_assignable, Types>::value...>::value;
+};
+
+// Type index of a variant with N alternatives, stored in the narrowest signed
+// integer that holds [0, N) and -1. Reads and writes go through std::size_t,
+// -1 sign extends to invalid_value so no extra check is needed.
+template <std::size_t N>
+class narrow_index
+{
+    using value_type = typename std::conditional<(N < 128), std::int8_t,
+                       typename std::conditional<(N < 32768), std::int16_t,
+                                                 std::int32_t>::type>::type;
+    value_type value_;
+
+public:
+    narrow_index() = default;
+
+    VARIANT_INLINE narrow_index(std::size_t index)
+        : value_(static_cast<value_type>(index)) {}
+
+    VARIANT_INLINE narrow_index& operator=(std::size_t index)
+    {
+        value_ = static_cast<value_type>(index);
+        return *this;
+    }
+
+    VARIANT_INLINE operator std::size_t() const
+    {
+        return static_cast<std::size_t>(value_);
+    }
+};
+
+// Storage of variant<Types...>. The special members are layered on top of it,
+// one base per member, each specialized on whether the member can stay
+// trivial. variant<Types...> defaults all of them, so it is trivially
+// copyable whenever all of its alternatives are.
+template <typename... Types>
+struct variant_storage
+{
+    static const std::size_t data_size = static_max<sizeof(Types)...>::value;
+    static const std::size_t data_align = static_max<alignof(Types)...>::value;
+
+    using data_type = typename std::aligned_storage<data_size, data_align>::type;
+    using helper_type = variant_helper<Types...>;
+
+    // the index goes last, it is usually narrower than the alignment of data
+    data_type data;
+    narrow_index<sizeof...(Types)> type_index;
+
+    variant_storage() = default;
+
+    VARIANT_INLINE explicit variant_storage(std::size_t index)
+        : type_index(index) {}
+
+    // A boxed alternative (recursive_wrapper and the like) may own the
+    // subtree rhs lives in, e.g. root = root.get<node>().left. The value held
+    // is then moved aside and only destroyed once rhs has been copied or
+    // moved in.
+    VARIANT_INLINE void copy_assign(variant_storage const& rhs)
+    {
+        if (holds_boxed())
+        {
+            temporary old(*this);
+            helper_type::copy(rhs.type_index, &rhs.data, &data);
+            type_index = rhs.type_index;
+            return;
+        }
+        if (type_index == rhs.type_index)
+        {
+            helper_type::copy_assign(type_index, &rhs.data, &data);
+            return;
+        }
+        helper_type::destroy(type_index, &data);
+        type_index = invalid_value;
+        helper_type::copy(rhs.type_index, &rhs.data, &data);
+        type_index = rhs.type_index;
+    }
+
+    VARIANT_INLINE void move_assign(variant_storage && rhs)
+    {
+        if (holds_boxed())
+        {
+            temporary old(*this);
+            helper_type::move(rhs.type_index, &rhs.data, &data);
+            type_index = rhs.type_index;
+            return;
+        }
+        if (type_index == rhs.type_index)
+        {
+            helper_type::move_assign(type_index, &rhs.data, &data);
+            return;
+        }
+        helper_type::destroy(type_index, &data);
+        type_index = invalid_value;
+        helper_type::move(rhs.type_index, &rhs.data, &data);
+        type_index = rhs.type_index;
+    }
+
+private:
+    // takes over the value of storage, leaving it empty, and destroys it on
+    // scope exit
+    struct temporary
+    {
+        variant_storage value;
+
+        VARIANT_INLINE explicit temporary(variant_storage & storage)
+            : value(storage.type_index)
+        {
+            helper_type::move(storage.type_index, &storage.data, &value.data);
+            helper_type::destroy(storage.type_index, &storage.data);
+            storage.type_index = invalid_value;
+        }
+
+        VARIANT_INLINE ~temporary()
+        {
+            helper_type::destroy(value.type_index, &value.data);
+        }
+    };
+
+    VARIANT_INLINE bool holds_boxed() const
+    {
+        static constexpr bool has_boxed = !static_all<!is_boxed<Types>::value...>::value;
+        static constexpr bool boxed[] = {is_boxed<Types>::value...};
+        return has_boxed && type_index < sizeof...(Types) && boxed[sizeof...(Types) - 1 - type_index];
+    }
+};
+
+template <bool Trivial, typename... Types>
+struct variant_destroy_base : variant_storage<Types...>
+{
+    using variant_storage<Types...>::variant_storage;
+};
+
+template <typename... Types>
+struct variant_destroy_base<false, Types...> : variant_storage<Types...>
+{
+    using variant_storage<Types...>::variant_storage;
+
+    variant_destroy_base() = default;
+    variant_destroy_base(variant_destroy_base const&) = default;
+    variant_destroy_base(variant_destroy_base &&) = default;
+    variant_destroy_base& operator=(variant_destroy_base const&) = default;
+    variant_destroy_base& operator=(variant_destroy_base &&) = default;
+
+    ~variant_destroy_base() noexcept
+    {
+        variant_helper<Types...>::destroy(this->type_index, &this->data);
+    }
+};
+
+template <bool Trivial, typename... Types>
+struct variant_copy_construct_base
+    : variant_destroy_base<variant_triviality<Types...>::destroy, Types...>
+{
+    using variant_destroy_base<variant_triviality<Types...>::destroy, Types...>::variant_destroy_base;
+};
+
+template <typename... Types>
+struct variant_copy_construct_base<false, Types...>
+    : variant_destroy_base<variant_triviality<Types...>::destroy, Types...>
+{
+    using base = variant_destroy_base<variant_triviality<Types...>::destroy, Types...>;
+    using base::base;
+
+    variant_copy_construct_base() = default;
+    variant_copy_construct_base(variant_copy_construct_base &&) = default;
+    variant_copy_construct_base& operator=(variant_copy_construct_base const&) = default;
+    variant_copy_construct_base& operator=(variant_copy_construct_base &&) = default;
+
+    // the index is set last, if the copy throws the destroy base must not
+    // destroy a half constructed value
+    VARIANT_INLINE variant_copy_construct_base(variant_copy_construct_base const& old)
+        : base(invalid_value)
+    {
+        variant_helper<Types...>::copy(old.type_index, &old.data, &this->data);
+        this->type_index = old.type_index;
+    }
+};
+
+template <bool Trivial, typename... Types>
+struct variant_move_construct_base
+    : variant_copy_construct_base<variant_triviality<Types...>::copy_construct, Types...>
+{
+    using variant_copy_construct_base<variant_triviality<Types...>::copy_construct, Types...>::variant_copy_construct_base;
+};
+
+template <typename... Types>
+struct variant_move_construct_base<false, Types...>
+    : variant_copy_construct_base<variant_triviality<Types...>::copy_construct, Types...>
+{
+    using base = variant_copy_construct_base<variant_triviality<Types...>::copy_construct, Types...>;
+    using base::base;
+
+    variant_move_construct_base() = default;
+    variant_move_construct_base(variant_move_construct_base const&) = default;
+    variant_move_construct_base& operator=(variant_move_construct_base const&) = default;
+    variant_move_construct_base& operator=(variant_move_construct_base &&) = default;
+
+    VARIANT_INLINE variant_move_construct_base(variant_move_construct_base && old) noexcept
+        : base(old.type_index)
+    {
+        variant_helper<Types...>::move(old.type_index, &old.data, &this->data);
+    }
+};
+
+template <bool Trivial, typename... Types>
+struct variant_copy_assign_base
+    : variant_move_construct_base<variant_triviality<Types...>::move_construct, Types...>
+{
+    using variant_move_construct_base<variant_triviality<Types...>::move_construct, Types...>::variant_move_construct_base;
+};
+
+template <typename... Types>
+struct variant_copy_assign_base<false, Types...>
+    : variant_move_construct_base<variant_triviality<Types...>::move_construct, Types...>
+{
+    using base = variant_move_construct_base<variant_triviality<Types...>::move_construct, Types...>;
+    using base::base;
+
+    variant_copy_assign_base() = default;
+    variant_copy_assign_base(variant_copy_assign_base const&) = default;
+    variant_copy_assign_base(variant_copy_assign_base &&) = default;
+    variant_copy_assign_base& operator=(variant_copy_assign_base &&) = default;
+
+    VARIANT_INLINE variant_copy_assign_base& operator=(variant_copy_assign_base const& rhs)
+    {
+        this->copy_assign(rhs);
+        return *this;
+    }
+};
+
+template <bool Trivial, typename... Types>
+struct variant_move_assign_base
+    : variant_copy_assign_base<variant_triviality<Types...>::copy_assign, Types...>
+{
+    using variant_copy_assign_base<variant_triviality<Types...>::copy_assign, Types...>::variant_copy_assign_base;
+};
+
+template <typename... Types>
+struct variant_move_assign_base<false, Types...>
+    : variant_copy_assign_base<variant_triviality<Types...>::copy_assign, Types...>
+{
+    using base = variant_copy_assign_base<variant_triviality<Types...>::copy_assign, Types...>;
+    using base::base;
+
+    variant_move_assign_base() = default;
+    variant_move_assign_base(variant_move_assign_base const&) = default;
+    variant_move_assign_base(variant_move_assign_base &&) = default;
+    variant_move_assign_base& operator=(variant_move_assign_base const&) = default;
+
+    VARIANT_INLINE variant_move_assign_base& operator=(variant_move_assign_base && rhs)
+    {
+        this->move_assign(std::move(rhs));
+        return *this;
+    }
+};
+
+template <typename... Types>
+using variant_base = variant_move_assign_base<variant_triviality<Types...>::move_assign, Types...>;
+
 template <typename T>
 struct unwrapper
 {
     static T const& apply_const(T const& obj) {return obj;}
     static T& apply(T & obj) {return obj;}
+    static T&& apply_rvalue(T & obj) {return std::move(obj);}
 };
 
-template <typename T>
-struct unwrapper<recursive_wrapper<T>>
+template <typename T, typename Alloc>
+struct unwrapper<recursive_wrapper<T, Alloc>>
 {
-    static auto apply_const(recursive_wrapper<T> const& obj)
-        -> typename recursive_wrapper<T>::type const&
+    static auto apply_const(recursive_wrapper<T, Alloc> const& obj)
+        -> typename recursive_wrapper<T, Alloc>::type const&
     {
         return obj.get();
     }
-    static auto apply(recursive_wrapper<T> & obj)
-        -> typename recursive_wrapper<T>::type&
+    static auto apply(recursive_wrapper<T, Alloc> & obj)
+        -> typename recursive_wrapper<T, Alloc>::type&
     {
         return obj.get();
     }
+    static auto apply_rvalue(recursive_wrapper<T, Alloc> & obj)
+        -> typename recursive_wrapper<T, Alloc>::type&&
+    {
+        return std::move(obj.get());
+    }
 };
 
 template <typename T>
@@ -281,6 +853,12 @@ struct unwrapper<std::reference_wrapper<T>>
     {
         return obj.get();
     }
+    // the referenced object isn't owned by the variant, never move from it
+    static auto apply_rvalue(std::reference_wrapper<T> & obj)
+        -> typename std::reference_wrapper<T>::type&
+    {
+        return obj.get();
+    }
 };
 
 template <typename F, typename V, typename R, typename... Types>
@@ -290,27 +868,39 @@ template <typename F, typename V, typename R, typename T, typename... Types>
 struct dispatcher<F, V, R, T, Types...>
 {
     using result_type = R;
-    VARIANT_INLINE static result_type apply_const(V const& v, F f)
+    VARIANT_INLINE static result_type apply_const(V const& v, F && f)
+    {
+        if (v.get_type_index() == sizeof...(Types))
+        {
+            return std::forward<F>(f)(unwrapper<T>::apply_const(v. template get<T>()));
+        }
+        else
+        {
+            return dispatcher<F, V, R, Types...>::apply_const(v, std::forward<F>(f));
+        }
+    }
+
+    VARIANT_INLINE static result_type apply(V & v, F && f)
     {
         if (v.get_type_index() == sizeof...(Types))
         {
-            return f(unwrapper<T>::apply_const(v. template get<T>()));
+            return std::forward<F>(f)(unwrapper<T>::apply(v. template get<T>()));
         }
         else
         {
-            return dispatcher<F, V, R, Types...>::apply_const(v, f);
+            return dispatcher<F, V, R, Types...>::apply(v, std::forward<F>(f));
         }
     }
 
-    VARIANT_INLINE static result_type apply(V & v, F f)
+    VARIANT_INLINE static result_type apply_rvalue(V & v, F && f)
     {
         if (v.get_type_index() == sizeof...(Types))
         {
-            return f(unwrapper<T>::apply(v. template get<T>()));
+            return std::forward<F>(f)(unwrapper<T>::apply_rvalue(v. template get<T>()));
         }
         else
         {
-            return dispatcher<F, V, R, Types...>::apply(v, f);
+            return dispatcher<F, V, R, Types...>::apply_rvalue(v, std::forward<F>(f));
         }
     }
 };
@@ -319,193 +909,431 @@ template <typename F, typename V, typename R, typename T>
 struct dispatcher<F, V, R, T>
 {
     using result_type = R;
-    VARIANT_INLINE static result_type apply_const(V const& v, F f)
+    VARIANT_INLINE static result_type apply_const(V const& v, F && f)
+    {
+        return std::forward<F>(f)(unwrapper<T>::apply_const(v. template get<T>()));
+    }
+
+    VARIANT_INLINE static result_type apply(V & v, F && f)
     {
-        return f(unwrapper<T>::apply_const(v. template get<T>()));
+        return std::forward<F>(f)(unwrapper<T>::apply(v. template get<T>()));
     }
 
-    VARIANT_INLINE static result_type apply(V & v, F f)
+    VARIANT_INLINE static result_type apply_rvalue(V & v, F && f)
     {
-        return f(unwrapper<T>::apply(v. template get<T>()));
+        return std::forward<F>(f)(unwrapper<T>::apply_rvalue(v. template get<T>()));
     }
 };
 
+// Dispatches with a balanced binary search over type_index in [Lo, Hi]. The
+// search covers one index past the last alternative: an invalid variant
+// (type_index == invalid_value) ends up there and throws.
+template <typename F, typename V, typename R, std::size_t I, bool Valid, typename... Types>
+struct binary_search_leaf
+{
+    using result_type = R;
+    using type = typename std::tuple_element<sizeof...(Types) - 1 - I, std::tuple<Types...>>::type;
 
-template <typename F, typename V, typename R, typename T, typename... Types>
-struct binary_dispatcher_rhs;
+    VARIANT_INLINE static result_type apply_const(V const& v, F && f)
+    {
+        return std::forward<F>(f)(unwrapper<type>::apply_const(v. template get_unchecked<type>()));
+    }
 
-template <typename F, typename V, typename R, typename T0, typename T1, typename... Types>
-struct binary_dispatcher_rhs<F, V, R, T0, T1, Types...>
+    VARIANT_INLINE static result_type apply(V & v, F && f)
+    {
+        return std::forward<F>(f)(unwrapper<type>::apply(v. template get_unchecked<type>()));
+    }
+
+    VARIANT_INLINE static result_type apply_rvalue(V & v, F && f)
+    {
+        return std::forward<F>(f)(unwrapper<type>::apply_rvalue(v. template get_unchecked<type>()));
+    }
+};
+
+template <typename F, typename V, typename R, std::size_t I, typename... Types>
+struct binary_search_leaf<F, V, R, I, false, Types...>
 {
     using result_type = R;
-    VARIANT_INLINE static result_type apply_const(V const& lhs, V const& rhs, F f)
+
+    static result_type apply_const(V const&, F &&)
+    {
+        throw bad_variant_access("in visit()");
+    }
+
+    static result_type apply(V &, F &&)
     {
-        if (rhs.get_type_index() == sizeof...(Types)) // call binary functor
+        throw bad_variant_access("in visit()");
+    }
+
+    static result_type apply_rvalue(V &, F &&)
+    {
+        throw bad_variant_access("in visit()");
+    }
+};
+
+template <typename F, typename V, typename R, std::size_t Lo, std::size_t Hi, typename... Types>
+struct binary_search_dispatcher
+{
+    using result_type = R;
+    static constexpr std::size_t mid = Lo + (Hi - Lo) / 2;
+    using lower = binary_search_dispatcher<F, V, R, Lo, mid, Types...>;
+    using upper = binary_search_dispatcher<F, V, R, mid + 1, Hi, Types...>;
+
+    VARIANT_INLINE static result_type apply_const(V const& v, F && f)
+    {
+        if (v.get_type_index() <= mid)
         {
-            return f(unwrapper<T0>::apply_const(lhs. template get<T0>()),
-                     unwrapper<T1>::apply_const(rhs. template get<T1>()));
+            return lower::apply_const(v, std::forward<F>(f));
         }
         else
         {
-            return binary_dispatcher_rhs<F, V, R, T0, Types...>::apply_const(lhs, rhs, f);
+            return upper::apply_const(v, std::forward<F>(f));
         }
     }
 
-    VARIANT_INLINE static result_type apply(V & lhs, V & rhs, F f)
+    VARIANT_INLINE static result_type apply(V & v, F && f)
     {
-        if (rhs.get_type_index() == sizeof...(Types)) // call binary functor
+        if (v.get_type_index() <= mid)
         {
-            return f(unwrapper<T0>::apply(lhs. template get<T0>()),
-                     unwrapper<T1>::apply(rhs. template get<T1>()));
+            return lower::apply(v, std::forward<F>(f));
         }
         else
         {
-            return binary_dispatcher_rhs<F, V, R, T0, Types...>::apply(lhs, rhs, f);
+            return upper::apply(v, std::forward<F>(f));
         }
     }
 
+    VARIANT_INLINE static result_type apply_rvalue(V & v, F && f)
+    {
+        if (v.get_type_index() <= mid)
+        {
+            return lower::apply_rvalue(v, std::forward<F>(f));
+        }
+        else
+        {
+            return upper::apply_rvalue(v, std::forward<F>(f));
+        }
+    }
+};
+
+template <typename F, typename V, typename R, std::size_t I, typename... Types>
+struct binary_search_dispatcher<F, V, R, I, I, Types...>
+    : binary_search_leaf<F, V, R, I, (I < sizeof...(Types)), Types...> {};
+
+// Dispatches through a table of per-alternative thunks, so the cost of a
+// visit doesn't depend on the number of alternatives. The table is indexed
+// by which(); the extra trailing entry is reached by an invalid variant
+// (type_index == invalid_value) and throws.
+template <typename F, typename V, typename R, typename... Types>
+struct table_dispatcher
+{
+    using result_type = R;
+    using const_thunk_type = result_type (*)(V const&, F &&);
+    using thunk_type = result_type (*)(V &, F &&);
+
+    template <typename T>
+    static result_type call_const(V const& v, F && f)
+    {
+        return std::forward<F>(f)(unwrapper<T>::apply_const(v. template get_unchecked<T>()));
+    }
+
+    template <typename T>
+    static result_type call(V & v, F && f)
+    {
+        return std::forward<F>(f)(unwrapper<T>::apply(v. template get_unchecked<T>()));
+    }
+
+    template <typename T>
+    static result_type call_rvalue(V & v, F && f)
+    {
+        return std::forward<F>(f)(unwrapper<T>::apply_rvalue(v. template get_unchecked<T>()));
+    }
+
+    static result_type invalid_const(V const&, F &&)
+    {
+        throw bad_variant_access("in visit()");
+    }
+
+    static result_type invalid(V &, F &&)
+    {
+        throw bad_variant_access("in visit()");
+    }
+
+    VARIANT_INLINE static result_type apply_const(V const& v, F && f)
+    {
+        static constexpr const_thunk_type table[] = { &call_const<Types>..., &invalid_const };
+        return table[sizeof...(Types) - 1 - v.get_type_index()](v, std::forward<F>(f));
+    }
+
+    VARIANT_INLINE static result_type apply(V & v, F && f)
+    {
+        static constexpr thunk_type table[] = { &call<Types>..., &invalid };
+        return table[sizeof...(Types) - 1 - v.get_type_index()](v, std::forward<F>(f));
+    }
+
+    VARIANT_INLINE static result_type apply_rvalue(V & v, F && f)
+    {
+        static constexpr thunk_type table[] = { &call_rvalue<Types>..., &invalid };
+        return table[sizeof...(Types) - 1 - v.get_type_index()](v, std::forward<F>(f));
+    }
 };
 
-template <typename F, typename V, typename R, typename T0, typename T1>
-struct binary_dispatcher_rhs<F, V, R, T0, T1>
+
+// Dispatches a binary visit through a single table of thunks, one for each
+// pair of alternatives. Both indices use a radix of sizeof...(Types) + 1 so
+// that the trailing row and column are reached by an invalid variant and throw.
+template <typename F, typename V, typename R, typename... Types>
+struct binary_table_dispatcher
 {
     using result_type = R;
-    VARIANT_INLINE static result_type apply_const(V const& lhs, V const& rhs, F f)
+    using const_thunk_type = result_type (*)(V const&, V const&, F &&);
+    using thunk_type = result_type (*)(V &, V &, F &&);
+
+    static constexpr std::size_t radix = sizeof...(Types) + 1;
+
+    template <std::size_t I>
+    using alternative = typename std::tuple_element<I, std::tuple<Types...>>::type;
+
+    template <std::size_t I, std::size_t J, typename std::enable_if<
+                                            (I < sizeof...(Types) && J < sizeof...(Types))
+                                            >::type* = nullptr>
+    static result_type call_const(V const& v0, V const& v1, F && f)
     {
-        return f(unwrapper<T0>::apply_const(lhs. template get<T0>()),
-                 unwrapper<T1>::apply_const(rhs. template get<T1>()));
+        return std::forward<F>(f)(unwrapper<alternative<I>>::apply_const(v0. template get_unchecked<alternative<I>>()),
+                 unwrapper<alternative<J>>::apply_const(v1. template get_unchecked<alternative<J>>()));
     }
 
-    VARIANT_INLINE static result_type apply(V & lhs, V & rhs, F f)
+    template <std::size_t I, std::size_t J, typename std::enable_if<
+                                            (I == sizeof...(Types) || J == sizeof...(Types))
+                                            >::type* = nullptr>
+    static result_type call_const(V const&, V const&, F &&)
     {
-        return f(unwrapper<T0>::apply(lhs. template get<T0>()),
-                 unwrapper<T1>::apply(rhs. template get<T1>()));
+        throw bad_variant_access("in binary_visit()");
     }
 
-};
+    template <std::size_t I, std::size_t J, typename std::enable_if<
+                                            (I < sizeof...(Types) && J < sizeof...(Types))
+                                            >::type* = nullptr>
+    static result_type call(V & v0, V & v1, F && f)
+    {
+        return std::forward<F>(f)(unwrapper<alternative<I>>::apply(v0. template get_unchecked<alternative<I>>()),
+                 unwrapper<alternative<J>>::apply(v1. template get_unchecked<alternative<J>>()));
+    }
+
+    template <std::size_t I, std::size_t J, typename std::enable_if<
+                                            (I == sizeof...(Types) || J == sizeof...(Types))
+                                            >::type* = nullptr>
+    static result_type call(V &, V &, F &&)
+    {
+        throw bad_variant_access("in binary_visit()");
+    }
+
+    VARIANT_INLINE static std::size_t offset(V const& v0, V const& v1)
+    {
+        return (sizeof...(Types) - 1 - v0.get_type_index()) * radix
+            + (sizeof...(Types) - 1 - v1.get_type_index());
+    }
+
+    template <std::size_t... Is>
+    VARIANT_INLINE static result_type apply_const(V const& v0, V const& v1, F && f, index_sequence<Is...>)
+    {
+        static constexpr const_thunk_type table[] = { &call_const<Is / radix, Is % radix>... };
+        return table[offset(v0, v1)](v0, v1, std::forward<F>(f));
+    }
+
+    template <std::size_t... Is>
+    VARIANT_INLINE static result_type apply(V & v0, V & v1, F && f, index_sequence<Is...>)
+    {
+        static constexpr thunk_type table[] = { &call<Is / radix, Is % radix>... };
+        return table[offset(v0, v1)](v0, v1, std::forward<F>(f));
+    }
+
+    VARIANT_INLINE static result_type apply_const(V const& v0, V const& v1, F && f)
+    {
+        return apply_const(v0, v1, std::forward<F>(f), make_index_sequence<radix * radix>());
+    }
+
+    VARIANT_INLINE static result_type apply(V & v0, V & v1, F && f)
+    {
+        return apply(v0, v1, std::forward<F>(f), make_index_sequence<radix * radix>());
+    }
+};
+
+template <typename Strategy, typename F, typename V, typename R, typename... Types>
+struct strategy_dispatcher;
+
+template <typename F, typename V, typename R, typename... Types>
+struct strategy_dispatcher<linear_dispatch, F, V, R, Types...>
+    : dispatcher<F, V, R, Types...> {};
+
+template <typename F, typename V, typename R, typename... Types>
+struct strategy_dispatcher<binary_search_dispatch, F, V, R, Types...>
+    : binary_search_dispatcher<F, V, R, 0, sizeof...(Types), Types...> {};
 
+template <typename F, typename V, typename R, typename... Types>
+struct strategy_dispatcher<table_dispatch, F, V, R, Types...>
+    : table_dispatcher<F, V, R, Types...> {};
 
-template <typename F, typename V, typename R,  typename T, typename... Types>
-struct binary_dispatcher_lhs;
+template <typename Hot, typename F, typename V, typename R, typename... Types>
+struct priority_dispatcher;
 
-template <typename F, typename V, typename R, typename T0, typename T1, typename... Types>
-struct binary_dispatcher_lhs<F, V, R, T0, T1, Types...>
+template <typename H, typename... Hs, typename F, typename V, typename R, typename... Types>
+struct priority_dispatcher<priority_dispatch<H, Hs...>, F, V, R, Types...>
 {
+    static_assert(has_type<H, Types...>::value, "invalid type in `priority_dispatch` for this variant");
+
     using result_type = R;
-    VARIANT_INLINE static result_type apply_const(V const& lhs, V const& rhs, F f)
+    using next = priority_dispatcher<priority_dispatch<Hs...>, F, V, R, Types...>;
+
+    VARIANT_INLINE static result_type apply_const(V const& v, F && f)
     {
-        if (lhs.get_type_index() == sizeof...(Types)) // call binary functor
+        if (v.get_type_index() == direct_type<H, Types...>::index)
         {
-            return f(unwrapper<T1>::apply_const(lhs. template get<T1>()),
-                     unwrapper<T0>::apply_const(rhs. template get<T0>()));
+            return std::forward<F>(f)(unwrapper<H>::apply_const(v. template get_unchecked<H>()));
         }
         else
         {
-            return binary_dispatcher_lhs<F, V, R, T0, Types...>::apply_const(lhs, rhs, f);
+            return next::apply_const(v, std::forward<F>(f));
         }
     }
 
-    VARIANT_INLINE static result_type apply(V & lhs, V & rhs, F f)
+    VARIANT_INLINE static result_type apply(V & v, F && f)
     {
-        if (lhs.get_type_index() == sizeof...(Types)) // call binary functor
+        if (v.get_type_index() == direct_type<H, Types...>::index)
         {
-            return f(unwrapper<T1>::apply(lhs. template get<T1>()),
-                     unwrapper<T0>::apply(rhs. template get<T0>()));
+            return std::forward<F>(f)(unwrapper<H>::apply(v. template get_unchecked<H>()));
         }
         else
         {
-            return binary_dispatcher_lhs<F, V, R, T0, Types...>::apply(lhs, rhs, f);
+            return next::apply(v, std::forward<F>(f));
         }
     }
 
+    VARIANT_INLINE static result_type apply_rvalue(V & v, F && f)
+    {
+        if (v.get_type_index() == direct_type<H, Types...>::index)
+        {
+            return std::forward<F>(f)(unwrapper<H>::apply_rvalue(v. template get_unchecked<H>()));
+        }
+        else
+        {
+            return next::apply_rvalue(v, std::forward<F>(f));
+        }
+    }
 };
 
-template <typename F, typename V, typename R, typename T0, typename T1>
-struct binary_dispatcher_lhs<F, V, R, T0, T1>
+template <typename F, typename V, typename R, typename... Types>
+struct priority_dispatcher<priority_dispatch<>, F, V, R, Types...>
+    : strategy_dispatcher<typename default_dispatch_strategy<sizeof...(Types)>::type, F, V, R, Types...> {};
+
+template <typename... Hot, typename F, typename V, typename R, typename... Types>
+struct strategy_dispatcher<priority_dispatch<Hot...>, F, V, R, Types...>
+    : priority_dispatcher<priority_dispatch<Hot...>, F, V, R, Types...> {};
+
+// const-correct access to an alternative for visitors over heterogeneous
+// argument lists
+template <typename T, typename V>
+VARIANT_INLINE auto unwrap_alternative(V const& v)
+    -> decltype(unwrapper<T>::apply_const(v. template get_unchecked<T>()))
 {
-    using result_type = R;
-    VARIANT_INLINE static result_type apply_const(V const& lhs, V const& rhs, F f)
-    {
-        return f(unwrapper<T1>::apply_const(lhs. template get<T1>()),
-                 unwrapper<T0>::apply_const(rhs. template get<T0>()));
-    }
+    return unwrapper<T>::apply_const(v. template get_unchecked<T>());
+}
 
-    VARIANT_INLINE static result_type apply(V & lhs, V & rhs, F f)
-    {
-        return f(unwrapper<T1>::apply(lhs. template get<T1>()),
-                 unwrapper<T0>::apply(rhs. template get<T0>()));
-    }
+template <typename T, typename V>
+VARIANT_INLINE auto unwrap_alternative(V & v)
+    -> decltype(unwrapper<T>::apply(v. template get_unchecked<T>()))
+{
+    return unwrapper<T>::apply(v. template get_unchecked<T>());
+}
 
-};
+template <typename T, typename V, typename = typename std::enable_if<
+                                  !std::is_lvalue_reference<V>::value && !std::is_const<V>::value>::type>
+VARIANT_INLINE auto unwrap_alternative(V && v)
+    -> decltype(unwrapper<T>::apply_rvalue(v. template get_unchecked<T>()))
+{
+    return unwrapper<T>::apply_rvalue(v. template get_unchecked<T>());
+}
 
+// product of the radices of the variants following position K
+template <std::size_t K, typename... Vs>
+struct multi_stride;
 
-template <typename F, typename V, typename R, typename... Types>
-struct binary_dispatcher;
+template <typename V, typename... Vs>
+struct multi_stride<0, V, Vs...> : static_product<(variant_traits<Vs>::size + 1)...> {};
 
-template <typename F, typename V, typename R, typename T, typename... Types>
-struct binary_dispatcher<F, V, R, T, Types...>
+template <std::size_t K, typename V, typename... Vs>
+struct multi_stride<K, V, Vs...> : multi_stride<K - 1, Vs...> {};
+
+// Dispatches a visit over any number of variants, possibly of different
+// types, through one flattened table. The indices of all variants are
+// combined into a single mixed-radix offset, with a radix of size + 1 per
+// variant so the trailing slot of each is reached by an invalid variant.
+template <typename F, typename R, typename Ks, typename... Vs>
+struct multi_table_dispatcher;
+
+template <typename F, typename R, std::size_t... Ks, typename... Vs>
+struct multi_table_dispatcher<F, R, index_sequence<Ks...>, Vs...>
 {
     using result_type = R;
-    VARIANT_INLINE static result_type apply_const(V const& v0, V const& v1, F f)
+    using thunk_type = result_type (*)(F &&, Vs &&...);
+
+    template <std::size_t K>
+    using variant_at = typename std::tuple_element<K, std::tuple<Vs...>>::type;
+
+    // alternative of the K-th variant selected by table entry Idx
+    template <std::size_t Idx, std::size_t K>
+    struct entry
     {
-        if (v0.get_type_index() == sizeof...(Types))
-        {
-            if (v0.get_type_index() == v1.get_type_index())
-            {
-                return f(unwrapper<T>::apply_const(v0. template get<T>()),
-                         unwrapper<T>::apply_const(v1. template get<T>())); // call binary functor
-            }
-            else
-            {
-                return binary_dispatcher_rhs<F, V, R, T, Types...>::apply_const(v0, v1, f);
-            }
-        }
-        else if (v1.get_type_index() == sizeof...(Types))
-        {
-            return binary_dispatcher_lhs<F, V, R, T, Types...>::apply_const(v0, v1, f);
-        }
-        return binary_dispatcher<F, V, R, Types...>::apply_const(v0, v1, f);
+        static constexpr std::size_t size = variant_traits<variant_at<K>>::size;
+        static constexpr std::size_t index = (Idx / multi_stride<K, Vs...>::value) % (size + 1);
+        static constexpr bool valid = index < size;
+    };
+
+    template <std::size_t Idx, std::size_t K>
+    using alternative = typename std::tuple_element<entry<Idx, K>::index,
+                                                    typename variant_traits<variant_at<K>>::types>::type;
+
+    template <std::size_t Idx, typename std::enable_if<
+                               static_all<entry<Idx, Ks>::valid...>::value
+                               >::type* = nullptr>
+    static result_type call(F && f, Vs &&... vs)
+    {
+        return std::forward<F>(f)(unwrap_alternative<alternative<Idx, Ks>>(std::forward<Vs>(vs))...);
     }
 
-    VARIANT_INLINE static result_type apply(V & v0, V & v1, F f)
+    template <std::size_t Idx, typename std::enable_if<
+                               !static_all<entry<Idx, Ks>::valid...>::value
+                               >::type* = nullptr>
+    static result_type call(F &&, Vs &&...)
     {
-        if (v0.get_type_index() == sizeof...(Types))
-        {
-            if (v0.get_type_index() == v1.get_type_index())
-            {
-                return f(unwrapper<T>::apply(v0. template get<T>()),
-                         unwrapper<T>::apply(v1. template get<T>())); // call binary functor
-            }
-            else
-            {
-                return binary_dispatcher_rhs<F, V, R, T, Types...>::apply(v0, v1, f);
-            }
-        }
-        else if (v1.get_type_index() == sizeof...(Types))
-        {
-            return binary_dispatcher_lhs<F, V, R, T, Types...>::apply(v0, v1, f);
-        }
-        return binary_dispatcher<F, V, R, Types...>::apply(v0, v1, f);
+        throw bad_variant_access("in visit()");
     }
-};
 
-template <typename F, typename V, typename R, typename T>
-struct binary_dispatcher<F, V, R, T>
-{
-    using result_type = R;
-    VARIANT_INLINE static result_type apply_const(V const& v0, V const& v1, F f)
+    VARIANT_INLINE static std::size_t offset(std::size_t acc)
     {
-        return f(unwrapper<T>::apply_const(v0. template get<T>()),
-                 unwrapper<T>::apply_const(v1. template get<T>())); // call binary functor
+        return acc;
     }
 
-    VARIANT_INLINE static result_type apply(V & v0, V & v1, F f)
+    template <typename V, typename... Rest>
+    VARIANT_INLINE static std::size_t offset(std::size_t acc, V const& v, Rest const&... rest)
     {
-        return f(unwrapper<T>::apply(v0. template get<T>()),
-                 unwrapper<T>::apply(v1. template get<T>())); // call binary functor
+        return offset(acc * (variant_traits<V>::size + 1)
+                      + (variant_traits<V>::size - 1 - v.get_type_index()), rest...);
+    }
+
+    template <std::size_t... Is>
+    VARIANT_INLINE static result_type apply(index_sequence<Is...>, F && f, Vs &&... vs)
+    {
+        static constexpr thunk_type table[] = { &call<Is>... };
+        return table[offset(0, vs...)](std::forward<F>(f), std::forward<Vs>(vs)...);
     }
-};
 
+    VARIANT_INLINE static result_type apply(F && f, Vs &&... vs)
+    {
+        return apply(make_index_sequence<static_product<(variant_traits<Vs>::size + 1)...>::value>(),
+                     std::forward<F>(f), std::forward<Vs>(vs)...);
+    }
+};
 
 // comparator functors
 struct equal_comp
@@ -545,99 +1373,310 @@ private:
 };
 
 
+template <typename T>
+VARIANT_INLINE T* relocate_n(T* src, std::size_t n, T* dest, std::true_type)
+{
+    if (n > 0)
+    {
+        std::memcpy(static_cast<void*>(dest), static_cast<void const*>(src), n * sizeof(T));
+    }
+    return dest + n;
+}
+
+template <typename T>
+VARIANT_INLINE T* relocate_n(T* src, std::size_t n, T* dest, std::false_type)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        new (dest + i) T(std::move(src[i]));
+        src[i].~T();
+    }
+    return dest + n;
+}
+
+} // namespace detail
+
+// Marks T as trivially relocatable: moving a T to a new address and ending
+// the lifetime of the old object is equivalent to copying its bytes and
+// forgetting the source (no destructor call). True for trivially copyable
+// types; specialize it for other types that don't point into themselves.
+template <typename T>
+struct is_trivially_relocatable
+    : std::integral_constant<bool, detail::is_trivially_move_constructible<T>::value
+                                   && detail::is_trivially_destructible<T>::value> {};
+
+template <typename T>
+struct is_trivially_relocatable<std::unique_ptr<T>> : std::true_type {};
+
+// the allocator is relocated along with the pointer
+template <typename T, typename Alloc>
+struct is_trivially_relocatable<recursive_wrapper<T, Alloc>>
+    : std::integral_constant<bool, std::is_empty<Alloc>::value || is_trivially_relocatable<Alloc>::value> {};
+
+#ifdef _LIBCPP_VERSION
+// libc++'s short string keeps its characters inline without a self pointer,
+// unlike libstdc++'s std::string
+template <>
+struct is_trivially_relocatable<std::string> : std::true_type {};
+#endif
+
+template <typename... Types>
+struct is_trivially_relocatable<variant<Types...>>
+    : std::integral_constant<bool, detail::static_all<is_trivially_relocatable<Types>::value...>::value> {};
+
+// Relocates the n objects at src to the uninitialized storage at dest, the
+// objects at src are dead afterwards and must not be destroyed. A single
+// memcpy for trivially relocatable types, move construction followed by
+// destruction of the source otherwise. The ranges must not overlap.
+template <typename T>
+VARIANT_INLINE T* uninitialized_relocate_n(T* src, std::size_t n, T* dest)
+{
+    return detail::relocate_n(src, n, dest, is_trivially_relocatable<T>());
+}
+
+#ifdef VARIANT_PROFILE_DISPATCH
+// Runtime type distribution of one visit site, i.e. one (visitor, variant)
+// pair, recorded by every unary visit when VARIANT_PROFILE_DISPATCH is
+// defined. Walk all sites with first()/next() and feed the hottest
+// alternatives into priority_dispatch.
+//
+// The macro changes the body of variant's inline visit functions, so define
+// it for every translation unit of a program (on the command line), never
+// in some of them only.
+class dispatch_profile
+{
+public:
+    dispatch_profile(std::type_info const& visitor,
+                     std::type_info const& variant_type,
+                     std::type_info const* const* alternatives,
+                     std::atomic<std::uint64_t> * counts,
+                     std::size_t size) noexcept
+        : visitor_(visitor),
+          variant_(variant_type),
+          alternatives_(alternatives),
+          counts_(counts),
+          size_(size),
+          next_(head().load(std::memory_order_relaxed))
+    {
+        while (!head().compare_exchange_weak(next_, this, std::memory_order_release, std::memory_order_relaxed)) {}
+    }
+
+    dispatch_profile(dispatch_profile const&) = delete;
+    dispatch_profile & operator=(dispatch_profile const&) = delete;
+
+    static dispatch_profile const* first() noexcept
+    {
+        return head().load(std::memory_order_acquire);
+    }
+
+    dispatch_profile const* next() const noexcept
+    {
+        return next_;
+    }
+
+    std::type_info const& visitor() const noexcept
+    {
+        return visitor_;
+    }
+
+    std::type_info const& variant_type() const noexcept
+    {
+        return variant_;
+    }
+
+    // number of alternatives
+    std::size_t size() const noexcept
+    {
+        return size_;
+    }
+
+    // type of the alternative with the given which() index
+    std::type_info const& alternative(std::size_t which) const noexcept
+    {
+        return *alternatives_[which];
+    }
+
+    // number of visits that found the alternative with the given which() index
+    std::uint64_t count(std::size_t which) const noexcept
+    {
+        return counts_[which].load(std::memory_order_relaxed);
+    }
+
+    void record(std::size_t which) noexcept
+    {
+        counts_[which].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void reset() noexcept
+    {
+        for (std::size_t i = 0; i < size_; ++i)
+        {
+            counts_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    static std::atomic<dispatch_profile *> & head() noexcept
+    {
+        static std::atomic<dispatch_profile *> head_{nullptr};
+        return head_;
+    }
+
+    std::type_info const& visitor_;
+    std::type_info const& variant_;
+    std::type_info const* const* alternatives_;
+    std::atomic<std::uint64_t> * counts_;
+    std::size_t size_;
+    dispatch_profile * next_;
+};
+
+namespace detail {
+
+template <typename F, typename V, typename... Types>
+struct dispatch_site
+{
+    static dispatch_profile & profile()
+    {
+        static std::atomic<std::uint64_t> counts[sizeof...(Types)];
+        static std::type_info const* const alternatives[] = { &typeid(Types)... };
+        static dispatch_profile site(typeid(F), typeid(V), alternatives, counts, sizeof...(Types));
+        return site;
+    }
+
+    VARIANT_INLINE static void record(std::size_t type_index)
+    {
+        if (type_index < sizeof...(Types))
+        {
+            profile().record(sizeof...(Types) - 1 - type_index);
+        }
+    }
+};
+
 } // namespace detail
+#endif
 
 struct no_init {};
 
+// tags selecting the alternative to construct in place, either by type or by
+// its zero based position in the type list (as returned by which())
+template <typename T>
+struct in_place_type_t {};
+
+template <std::size_t I>
+struct in_place_index_t {};
+
 template <typename... Types>
-class variant
+class variant : private detail::variant_base<Types...>
 {
     static_assert(sizeof...(Types) > 0, "Template parameter type list of variant can not be empty");
 
 private:
 
-    static const std::size_t data_size = detail::static_max<sizeof(Types)...>::value;
-    static const std::size_t data_align = detail::static_max<alignof(Types)...>::value;
-
+    using base_type = detail::variant_base<Types...>;
     using first_type = typename std::tuple_element<0, std::tuple<Types...>>::type;
-    using data_type = typename std::aligned_storage<data_size, data_align>::type;
     using helper_type = detail::variant_helper<Types...>;
 
-    std::size_t type_index;
-    data_type data;
+    template <std::size_t I>
+    using alternative_type = typename std::tuple_element<I, std::tuple<Types...>>::type;
+
+    using base_type::type_index;
+    using base_type::data;
+    using base_type::copy_assign;
+    using base_type::move_assign;
 
 public:
 
+    // constructors that may throw set type_index only once the value is
+    // constructed, see variant_copy_construct_base
     VARIANT_INLINE variant()
-        : type_index(sizeof...(Types) - 1)
+        : base_type(detail::invalid_value)
     {
         static_assert(std::is_default_constructible<first_type>::value, "First type in variant must be default constructible to allow default construction of variant");
         new (&data) first_type();
+        type_index = sizeof...(Types) - 1;
     }
 
     VARIANT_INLINE variant(no_init)
-        : type_index(detail::invalid_value) {}
+        : base_type(detail::invalid_value) {}
 
     // http://isocpp.org/blog/2012/11/universal-references-in-c11-scott-meyers
     template <typename T, class = typename std::enable_if<
                           detail::is_valid_type<typename std::remove_reference<T>::type, Types...>::value>::type>
     VARIANT_INLINE variant(T && val) noexcept
-        : type_index(detail::value_traits<typename std::remove_reference<T>::type, Types...>::index)
+        : base_type(detail::value_traits<typename std::remove_reference<T>::type, Types...>::index)
     {
         constexpr std::size_t index = sizeof...(Types) - detail::value_traits<typename std::remove_reference<T>::type, Types...>::index - 1;
         using target_type = typename std::tuple_element<index, std::tuple<Types...>>::type;
         new (&data) target_type(std::forward<T>(val)); // nothrow
     }
 
-    VARIANT_INLINE variant(variant<Types...> const& old)
-        : type_index(old.type_index)
+    template <typename T, typename... Args, class = typename std::enable_if<
+                                           detail::direct_type<T, Types...>::index != detail::invalid_value>::type>
+    VARIANT_INLINE explicit variant(in_place_type_t<T>, Args &&... args)
+        : base_type(detail::invalid_value)
     {
-        helper_type::copy(old.type_index, &old.data, &data);
+        new (&data) T(std::forward<Args>(args)...);
+        type_index = detail::direct_type<T, Types...>::index;
     }
 
-    VARIANT_INLINE variant(variant<Types...> && old) noexcept
-        : type_index(old.type_index)
+    template <std::size_t I, typename... Args, class = typename std::enable_if<
+                                               (I < sizeof...(Types))>::type>
+    VARIANT_INLINE explicit variant(in_place_index_t<I>, Args &&... args)
+        : base_type(detail::invalid_value)
     {
-        helper_type::move(old.type_index, &old.data, &data);
+        new (&data) alternative_type<I>(std::forward<Args>(args)...);
+        type_index = sizeof...(Types) - I - 1;
     }
 
+    // copy/move construction, assignment and destruction are implemented in
+    // detail::variant_base and stay trivial when all alternatives allow it
+    variant(variant<Types...> const&) = default;
+    variant(variant<Types...> &&) = default;
+    variant<Types...>& operator=(variant<Types...> const&) = default;
+    variant<Types...>& operator=(variant<Types...> &&) = default;
+    ~variant() = default;
+
 private:
-    VARIANT_INLINE void copy_assign(variant<Types...> const& rhs)
-    {
-        helper_type::destroy(type_index, &data);
-        type_index = detail::invalid_value;
-        helper_type::copy(rhs.type_index, &rhs.data, &data);
-        type_index = rhs.type_index;
-    }
 
-    VARIANT_INLINE void move_assign(variant<Types...> && rhs)
+    // rhs converts to one of the alternatives, assign it directly when that
+    // alternative is already active
+    template <typename T>
+    VARIANT_INLINE void converting_assign(T && rhs, std::true_type)
     {
-        helper_type::destroy(type_index, &data);
-        type_index = detail::invalid_value;
-        helper_type::move(rhs.type_index, &rhs.data, &data);
-        type_index = rhs.type_index;
+        constexpr std::size_t index = detail::value_traits<typename std::remove_reference<T>::type, Types...>::index;
+        using target_type = typename std::tuple_element<sizeof...(Types) - index - 1, std::tuple<Types...>>::type;
+        if (type_index == index)
+        {
+            detail::variant_helper<target_type>::assign(
+                *reinterpret_cast<target_type*>(&data), std::forward<T>(rhs),
+                std::integral_constant<bool, std::is_assignable<target_type&, T&&>::value>());
+        }
+        else
+        {
+            variant<Types...> temp(std::forward<T>(rhs));
+            move_assign(std::move(temp));
+        }
     }
 
-public:
-    VARIANT_INLINE variant<Types...>& operator=(variant<Types...> &&  other)
+    template <typename T>
+    VARIANT_INLINE void converting_assign(T && rhs, std::false_type)
     {
-        move_assign(std::move(other));
-        return *this;
+        variant<Types...> temp(std::forward<T>(rhs));
+        move_assign(std::move(temp));
     }
 
-    VARIANT_INLINE variant<Types...>& operator=(variant<Types...> const& other)
-    {
-        copy_assign(other);
-        return *this;
-    }
+    template <typename T>
+    using is_converting_assignment = std::integral_constant<bool,
+        detail::is_valid_type<typename std::remove_reference<T>::type, Types...>::value>;
 
+public:
     // conversions
-    // move-assign
-    template <typename T>
+    // move-assign, a non-const lvalue variant goes to the copy assignment
+    template <typename T, class = typename std::enable_if<
+                          !std::is_same<typename std::decay<T>::type, variant<Types...>>::value>::type>
     VARIANT_INLINE variant<Types...>& operator=(T && rhs) noexcept
     {
-        variant<Types...> temp(std::forward<T>(rhs));
-        move_assign(std::move(temp));
+        converting_assign(std::forward<T>(rhs), is_converting_assignment<T>());
         return *this;
     }
 
@@ -645,16 +1684,15 @@ public:
     template <typename T>
     VARIANT_INLINE variant<Types...>& operator=(T const& rhs)
     {
-        variant<Types...> temp(rhs);
-        copy_assign(temp);
+        converting_assign(rhs, is_converting_assignment<T const&>());
         return *this;
     }
 
     template <typename T>
     VARIANT_INLINE bool is() const
     {
-        static_assert(detail::has_type<T, Types...>::value, "invalid type in T in `is<T>()` for this variant");
-        return type_index == detail::direct_type<T, Types...>::index;
+        static_assert(detail::held_type<T, Types...>::index != detail::invalid_value, "invalid type in T in `is<T>()` for this variant");
+        return type_index == detail::held_type<T, Types...>::index;
     }
 
     VARIANT_INLINE bool valid() const
@@ -665,17 +1703,40 @@ public:
     template <typename T, typename... Args>
     VARIANT_INLINE void set(Args &&... args)
     {
+        emplace<T>(std::forward<Args>(args)...);
+    }
+
+    // emplace<T>(args...) - destroys the held value and constructs T from
+    // args directly in the variant's storage
+    template <typename T, typename... Args>
+    VARIANT_INLINE T & emplace(Args &&... args)
+    {
+        static_assert(detail::has_type<T, Types...>::value, "invalid type in T in `emplace<T>()` for this variant");
         helper_type::destroy(type_index, &data);
         type_index = detail::invalid_value;
         new (&data) T(std::forward<Args>(args)...);
         type_index = detail::direct_type<T, Types...>::index;
+        return *reinterpret_cast<T*>(&data);
+    }
+
+    // emplace<I>(args...) - I is the position of the alternative in Types...
+    template <std::size_t I, typename... Args>
+    VARIANT_INLINE alternative_type<I> & emplace(Args &&... args)
+    {
+        static_assert(I < sizeof...(Types), "invalid index in I in `emplace<I>()` for this variant");
+        using T = alternative_type<I>;
+        helper_type::destroy(type_index, &data);
+        type_index = detail::invalid_value;
+        new (&data) T(std::forward<Args>(args)...);
+        type_index = sizeof...(Types) - I - 1;
+        return *reinterpret_cast<T*>(&data);
     }
 
     // get<T>()
     template <typename T, typename std::enable_if<
                           (detail::direct_type<T, Types...>::index != detail::invalid_value)
                           >::type* = nullptr>
-    VARIANT_INLINE T & get()
+    VARIANT_INLINE T & get() &
     {
         if (type_index == detail::direct_type<T, Types...>::index)
         {
@@ -690,7 +1751,22 @@ public:
     template <typename T, typename std::enable_if<
                           (detail::direct_type<T, Types...>::index != detail::invalid_value)
                           >::type* = nullptr>
-    VARIANT_INLINE T const& get() const
+    VARIANT_INLINE T && get() &&
+    {
+        if (type_index == detail::direct_type<T, Types...>::index)
+        {
+            return std::move(*reinterpret_cast<T*>(&data));
+        }
+        else
+        {
+            throw bad_variant_access("in get<T>()");
+        }
+    }
+
+    template <typename T, typename std::enable_if<
+                          (detail::direct_type<T, Types...>::index != detail::invalid_value)
+                          >::type* = nullptr>
+    VARIANT_INLINE T const& get() const&
     {
         if (type_index == detail::direct_type<T, Types...>::index)
         {
@@ -702,15 +1778,30 @@ public:
         }
     }
 
-    // get<T>() - T stored as recursive_wrapper<T>
+    // get<T>() - T stored boxed, e.g. as recursive_wrapper<T, Alloc>
+    template <typename T, typename std::enable_if<
+                          (detail::wrapped_type<T, Types...>::index != detail::invalid_value)
+                          >::type* = nullptr>
+    VARIANT_INLINE T & get() &
+    {
+        if (type_index == detail::wrapped_type<T, Types...>::index)
+        {
+            return (*reinterpret_cast<typename detail::wrapped_type<T, Types...>::type*>(&data)).get();
+        }
+        else
+        {
+            throw bad_variant_access("in get<T>()");
+        }
+    }
+
     template <typename T, typename std::enable_if<
-                          (detail::direct_type<recursive_wrapper<T>, Types...>::index != detail::invalid_value)
+                          (detail::wrapped_type<T, Types...>::index != detail::invalid_value)
                           >::type* = nullptr>
-    VARIANT_INLINE T & get()
+    VARIANT_INLINE T && get() &&
     {
-        if (type_index == detail::direct_type<recursive_wrapper<T>, Types...>::index)
+        if (type_index == detail::wrapped_type<T, Types...>::index)
         {
-            return (*reinterpret_cast<recursive_wrapper<T>*>(&data)).get();
+            return std::move((*reinterpret_cast<typename detail::wrapped_type<T, Types...>::type*>(&data)).get());
         }
         else
         {
@@ -719,13 +1810,13 @@ public:
     }
 
     template <typename T,typename std::enable_if<
-                         (detail::direct_type<recursive_wrapper<T>, Types...>::index != detail::invalid_value)
+                         (detail::wrapped_type<T, Types...>::index != detail::invalid_value)
                          >::type* = nullptr>
-    VARIANT_INLINE T const& get() const
+    VARIANT_INLINE T const& get() const&
     {
-        if (type_index == detail::direct_type<recursive_wrapper<T>, Types...>::index)
+        if (type_index == detail::wrapped_type<T, Types...>::index)
         {
-            return (*reinterpret_cast<recursive_wrapper<T> const*>(&data)).get();
+            return (*reinterpret_cast<typename detail::wrapped_type<T, Types...>::type const*>(&data)).get();
         }
         else
         {
@@ -737,7 +1828,24 @@ public:
     template <typename T, typename std::enable_if<
                           (detail::direct_type<std::reference_wrapper<T>, Types...>::index != detail::invalid_value)
                           >::type* = nullptr>
-    VARIANT_INLINE T& get()
+    VARIANT_INLINE T& get() &
+    {
+        if (type_index == detail::direct_type<std::reference_wrapper<T>, Types...>::index)
+        {
+            return (*reinterpret_cast<std::reference_wrapper<T>*>(&data)).get();
+        }
+        else
+        {
+            throw bad_variant_access("in get<T>()");
+        }
+    }
+
+    // the referenced object isn't owned by the variant, so an rvalue variant
+    // still hands out an lvalue reference
+    template <typename T, typename std::enable_if<
+                          (detail::direct_type<std::reference_wrapper<T>, Types...>::index != detail::invalid_value)
+                          >::type* = nullptr>
+    VARIANT_INLINE T& get() &&
     {
         if (type_index == detail::direct_type<std::reference_wrapper<T>, Types...>::index)
         {
@@ -752,7 +1860,7 @@ public:
     template <typename T,typename std::enable_if<
                          (detail::direct_type<std::reference_wrapper<T const>, Types...>::index != detail::invalid_value)
                          >::type* = nullptr>
-    VARIANT_INLINE T const& get() const
+    VARIANT_INLINE T const& get() const&
     {
         if (type_index == detail::direct_type<std::reference_wrapper<T const>, Types...>::index)
         {
@@ -764,6 +1872,24 @@ public:
         }
     }
 
+    // get_unchecked<T>() - no type_index check, caller must make sure T is
+    // the type currently held
+    template <typename T, typename std::enable_if<
+                          (detail::direct_type<T, Types...>::index != detail::invalid_value)
+                          >::type* = nullptr>
+    VARIANT_INLINE T & get_unchecked()
+    {
+        return *reinterpret_cast<T*>(&data);
+    }
+
+    template <typename T, typename std::enable_if<
+                          (detail::direct_type<T, Types...>::index != detail::invalid_value)
+                          >::type* = nullptr>
+    VARIANT_INLINE T const& get_unchecked() const
+    {
+        return *reinterpret_cast<T const*>(&data);
+    }
+
     VARIANT_INLINE std::size_t get_type_index() const
     {
         return type_index;
@@ -778,53 +1904,76 @@ public:
     // unary
     template <typename F, typename V>
     auto VARIANT_INLINE
-    static visit(V const& v, F f)
-        -> decltype(detail::dispatcher<F, V,
+    static visit(V const& v, F && f)
+        -> decltype(detail::strategy_dispatcher<
+                    typename detail::visitor_dispatch_strategy<F, variant>::type, F, V,
                     typename detail::result_of_unary_visit<F,
-                    first_type>::type, Types...>::apply_const(v, f))
+                    first_type>::type, Types...>::apply_const(v, std::forward<F>(f)))
     {
         using R = typename detail::result_of_unary_visit<F, first_type>::type;
-        return detail::dispatcher<F, V, R, Types...>::apply_const(v, f);
+        using S = typename detail::visitor_dispatch_strategy<F, variant>::type;
+#ifdef VARIANT_PROFILE_DISPATCH
+        detail::dispatch_site<typename std::decay<F>::type, variant, Types...>::record(v.get_type_index());
+#endif
+        return detail::strategy_dispatcher<S, F, V, R, Types...>::apply_const(v, std::forward<F>(f));
     }
     // non-const
     template <typename F, typename V>
     auto VARIANT_INLINE
-    static visit(V & v, F f)
-        -> decltype(detail::dispatcher<F, V,
+    static visit(V & v, F && f)
+        -> decltype(detail::strategy_dispatcher<
+                    typename detail::visitor_dispatch_strategy<F, variant>::type, F, V,
+                    typename detail::result_of_unary_visit<F,
+                    first_type>::type, Types...>::apply(v, std::forward<F>(f)))
+    {
+        using R = typename detail::result_of_unary_visit<F, first_type>::type;
+        using S = typename detail::visitor_dispatch_strategy<F, variant>::type;
+#ifdef VARIANT_PROFILE_DISPATCH
+        detail::dispatch_site<typename std::decay<F>::type, variant, Types...>::record(v.get_type_index());
+#endif
+        return detail::strategy_dispatcher<S, F, V, R, Types...>::apply(v, std::forward<F>(f));
+    }
+
+    // rvalue
+    template <typename F, typename V, typename = typename std::enable_if<
+                                      !std::is_lvalue_reference<V>::value && !std::is_const<V>::value>::type>
+    auto VARIANT_INLINE
+    static visit(V && v, F && f)
+        -> decltype(detail::strategy_dispatcher<
+                    typename detail::visitor_dispatch_strategy<F, variant>::type, F, V,
                     typename detail::result_of_unary_visit<F,
-                    first_type>::type, Types...>::apply(v, f))
+                    first_type>::type, Types...>::apply_rvalue(v, std::forward<F>(f)))
     {
         using R = typename detail::result_of_unary_visit<F, first_type>::type;
-        return detail::dispatcher<F, V, R, Types...>::apply(v, f);
+        using S = typename detail::visitor_dispatch_strategy<F, variant>::type;
+#ifdef VARIANT_PROFILE_DISPATCH
+        detail::dispatch_site<typename std::decay<F>::type, variant, Types...>::record(v.get_type_index());
+#endif
+        return detail::strategy_dispatcher<S, F, V, R, Types...>::apply_rvalue(v, std::forward<F>(f));
     }
 
     // binary
     // const
     template <typename F, typename V>
     auto VARIANT_INLINE
-    static binary_visit(V const& v0, V const& v1, F f)
-        -> decltype(detail::binary_dispatcher<F, V,
+    static binary_visit(V const& v0, V const& v1, F && f)
+        -> decltype(detail::binary_table_dispatcher<F, V,
                     typename detail::result_of_binary_visit<F,
-                    first_type>::type, Types...>::apply_const(v0, v1, f))
+                    first_type>::type, Types...>::apply_const(v0, v1, std::forward<F>(f)))
     {
         using R = typename detail::result_of_binary_visit<F, first_type>::type;
-        return detail::binary_dispatcher<F, V, R, Types...>::apply_const(v0, v1, f);
+        return detail::binary_table_dispatcher<F, V, R, Types...>::apply_const(v0, v1, std::forward<F>(f));
     }
     // non-const
     template <typename F, typename V>
     auto VARIANT_INLINE
-    static binary_visit(V& v0, V& v1, F f)
-        -> decltype(detail::binary_dispatcher<F, V,
+    static binary_visit(V& v0, V& v1, F && f)
+        -> decltype(detail::binary_table_dispatcher<F, V,
                     typename detail::result_of_binary_visit<F,
-                    first_type>::type, Types...>::apply(v0, v1, f))
+                    first_type>::type, Types...>::apply(v0, v1, std::forward<F>(f)))
     {
         using R = typename detail::result_of_binary_visit<F, first_type>::type;
-        return detail::binary_dispatcher<F, V, R, Types...>::apply(v0, v1, f);
-    }
-
-    ~variant() noexcept
-    {
-        helper_type::destroy(type_index, &data);
+        return detail::binary_table_dispatcher<F, V, R, Types...>::apply(v0, v1, std::forward<F>(f));
     }
 
     // comparison operators
@@ -849,33 +1998,62 @@ public:
     }
 };
 
+// Variant with every alternative larger than Threshold bytes held in a
+// recursive_wrapper on the heap, so the inline storage is sized by the small
+// alternatives. Visitors, get<T>() and is<T>() still use the plain T.
+template <std::size_t Threshold, typename... Types>
+using boxed_variant = variant<typename detail::box_if_larger<Types, Threshold>::type...>;
+
 // unary visitor interface
 
 // const
 template <typename V, typename F>
-auto VARIANT_INLINE apply_visitor(F f, V const& v) -> decltype(V::visit(v, f))
+auto VARIANT_INLINE apply_visitor(F && f, V const& v) -> decltype(V::visit(v, std::forward<F>(f)))
 {
-    return V::visit(v, f);
+    return V::visit(v, std::forward<F>(f));
 }
 // non-const
 template <typename V, typename F>
-auto VARIANT_INLINE apply_visitor(F f, V & v) -> decltype(V::visit(v, f))
+auto VARIANT_INLINE apply_visitor(F && f, V & v) -> decltype(V::visit(v, std::forward<F>(f)))
+{
+    return V::visit(v, std::forward<F>(f));
+}
+
+// rvalue
+template <typename V, typename F, typename = typename std::enable_if<
+                                  !std::is_lvalue_reference<V>::value && !std::is_const<V>::value>::type>
+auto VARIANT_INLINE apply_visitor(F && f, V && v) -> decltype(V::visit(std::move(v), std::forward<F>(f)))
 {
-    return V::visit(v, f);
+    return V::visit(std::move(v), std::forward<F>(f));
 }
 
 // binary visitor interface
 // const
 template <typename V, typename F>
-auto VARIANT_INLINE apply_visitor(F f, V const& v0, V const& v1) -> decltype(V::binary_visit(v0, v1, f))
+auto VARIANT_INLINE apply_visitor(F && f, V const& v0, V const& v1) -> decltype(V::binary_visit(v0, v1, std::forward<F>(f)))
 {
-    return V::binary_visit(v0, v1, f);
+    return V::binary_visit(v0, v1, std::forward<F>(f));
 }
 // non-const
 template <typename V, typename F>
-auto VARIANT_INLINE apply_visitor(F f, V & v0, V & v1) -> decltype(V::binary_visit(v0, v1, f))
+auto VARIANT_INLINE apply_visitor(F && f, V & v0, V & v1) -> decltype(V::binary_visit(v0, v1, std::forward<F>(f)))
+{
+    return V::binary_visit(v0, v1, std::forward<F>(f));
+}
+
+// n-ary visitor interface, the variants may be of different types, constness
+// and value category; alternatives of rvalue variants are passed on as rvalues
+template <typename F, typename V0, typename V1, typename... Vs, typename = typename std::enable_if<
+                                  detail::static_all<detail::is_variant<typename std::decay<V0>::type>::value,
+                                                     detail::is_variant<typename std::decay<V1>::type>::value,
+                                                     detail::is_variant<typename std::decay<Vs>::type>::value...>::value>::type>
+auto VARIANT_INLINE apply_visitor(F && f, V0 && v0, V1 && v1, Vs &&... vs)
+    -> typename detail::result_of_multi_visit<F, V0, V1, Vs...>::type
 {
-    return V::binary_visit(v0, v1, f);
+    using R = typename detail::result_of_multi_visit<F, V0, V1, Vs...>::type;
+    return detail::multi_table_dispatcher<F, R, detail::make_index_sequence<sizeof...(Vs) + 2>,
+                                          V0, V1, Vs...>::apply(std::forward<F>(f), std::forward<V0>(v0),
+                                                                std::forward<V1>(v1), std::forward<Vs>(vs)...);
 }
 
 // getter interface
@@ -891,6 +2069,12 @@ ResultType const& get(T const& var)
     return var.template get<ResultType>();
 }
 
+template <typename ResultType, typename... Types>
+auto get(variant<Types...> && var) -> decltype(std::move(var).template get<ResultType>())
+{
+    return std::move(var).template get<ResultType>();
+}
+
 
 }}
 